@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+
+#include "lockfree/backoff.hpp"
+#include "lockfree/cas_loop.hpp"
+#include "lockfree/exchange_buffer.hpp"
+#include "lockfree/free_list_index_pool.hpp"
+#include "lockfree/sync_counter.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace {
+
+// Throughput (ops/s) of contended CAS loops for each backoff policy depending
+// on the number of threads (1 to 64). All threads operate on the same object,
+// i.e. every operation competes for the same cache line(s).
+//
+// use e.g. --benchmark_filter='fetch_multiply' to select a subset
+
+using lockfree::ExponentialBackoff;
+using lockfree::NoBackoff;
+using lockfree::SpinThenYieldBackoff;
+
+constexpr uint32_t CAPACITY = 128; // one slot per thread plus the buffer
+
+template <class Backoff> void fetch_multiply(benchmark::State &state) {
+  static std::atomic<int> value{1};
+  for (auto _ : state) {
+    // alternates the sign, the value stays bounded
+    benchmark::DoNotOptimize(lockfree::fetch_multiply<Backoff>(value, -1));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <class Backoff> void sync_counter_increment(benchmark::State &state) {
+  static lockfree::SyncCounter counter;
+  for (auto _ : state) {
+    counter.increment<Backoff>();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// every thread writes and takes, i.e. both CAS loops of the buffer contend
+template <class Backoff>
+void exchange_buffer_write_take(benchmark::State &state) {
+  using Buffer =
+      lockfree::ExchangeBuffer<uint64_t, CAPACITY,
+                               lockfree::FreeListIndexPool<CAPACITY>, Backoff>;
+  static Buffer buffer;
+  uint64_t value = state.thread_index();
+  for (auto _ : state) {
+    buffer.write(value);
+    benchmark::DoNotOptimize(buffer.take());
+  }
+  state.SetItemsProcessed(2 * state.iterations());
+}
+
+#define BACKOFF_BENCHMARK(func, policy)                                        \
+  BENCHMARK_TEMPLATE(func, policy)->ThreadRange(1, 64)->UseRealTime()
+
+BACKOFF_BENCHMARK(fetch_multiply, NoBackoff);
+BACKOFF_BENCHMARK(fetch_multiply, ExponentialBackoff<>);
+BACKOFF_BENCHMARK(fetch_multiply, SpinThenYieldBackoff<>);
+
+BACKOFF_BENCHMARK(sync_counter_increment, NoBackoff);
+BACKOFF_BENCHMARK(sync_counter_increment, ExponentialBackoff<>);
+BACKOFF_BENCHMARK(sync_counter_increment, SpinThenYieldBackoff<>);
+
+BACKOFF_BENCHMARK(exchange_buffer_write_take, NoBackoff);
+BACKOFF_BENCHMARK(exchange_buffer_write_take, ExponentialBackoff<>);
+BACKOFF_BENCHMARK(exchange_buffer_write_take, SpinThenYieldBackoff<>);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include "lockfree/batch.hpp"
+#include "lockfree/exchange_buffer.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Single-threaded cost of writing a batch of updates (one write per update vs
+// write_batch) and of draining many buffers (one take per buffer vs take_all)
+// depending on the batch size and the number of buffers (Arg).
+
+constexpr uint32_t CAPACITY = 8;
+constexpr size_t MAX_BUFFERS = 1024;
+
+using Buffer = lockfree::ExchangeBuffer<uint64_t, CAPACITY>;
+
+void write_each(benchmark::State &state) {
+  Buffer buffer;
+  std::vector<uint64_t> values(state.range(0), 73);
+  for (auto _ : state) {
+    for (auto &value : values) {
+      buffer.write(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+void write_batch(benchmark::State &state) {
+  Buffer buffer;
+  std::vector<uint64_t> values(state.range(0), 73);
+  for (auto _ : state) {
+    lockfree::write_batch(buffer, values.begin(), values.end());
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// every 4th buffer contains a value
+void fill(std::array<Buffer, MAX_BUFFERS> &buffers, size_t n) {
+  for (size_t i = 0; i < n; i += 4) {
+    buffers[i].write(i);
+  }
+}
+
+void take_each(benchmark::State &state) {
+  auto buffers = std::make_unique<std::array<Buffer, MAX_BUFFERS>>();
+  const size_t n = state.range(0);
+  uint64_t sum = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    fill(*buffers, n);
+    state.ResumeTiming();
+    for (size_t i = 0; i < n; ++i) {
+      if (auto value = (*buffers)[i].take()) {
+        sum += *value;
+      }
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+void take_all(benchmark::State &state) {
+  auto buffers = std::make_unique<std::array<Buffer, MAX_BUFFERS>>();
+  const size_t n = state.range(0);
+  std::vector<Buffer *> selected;
+  for (size_t i = 0; i < n; ++i) {
+    selected.push_back(&(*buffers)[i]);
+  }
+  uint64_t sum = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    fill(*buffers, n);
+    state.ResumeTiming();
+    lockfree::take_all(selected, [&](size_t, uint64_t value) { sum += value; });
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(write_each)->RangeMultiplier(4)->Range(1, 64);
+BENCHMARK(write_batch)->RangeMultiplier(4)->Range(1, 64);
+BENCHMARK(take_each)->RangeMultiplier(4)->Range(16, MAX_BUFFERS);
+BENCHMARK(take_all)->RangeMultiplier(4)->Range(16, MAX_BUFFERS);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,268 @@
+#include <benchmark/benchmark.h>
+
+#include "lockfree/exchange_buffer.hpp"
+#include "lockfree/spsc_exchange_buffer.hpp"
+#include "lockfree/spsc_take_buffer.hpp"
+#include "lockfree/take_buffer.hpp"
+#include "not_lockfree/exchange_buffer.hpp"
+#include "not_lockfree/take_buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Measures throughput (ops/s) and latency percentiles of the buffer
+// operations for different numbers of producer (writer) and consumer
+// (reader) threads and different payload sizes.
+//
+// Threads with index < number of producers perform the producer operation
+// (write or try_write), all others the consumer operation (take or read).
+//
+// Latencies are measured for every LATENCY_SAMPLE_INTERVAL-th operation to
+// keep the clock overhead out of the throughput. The percentiles are computed
+// per thread and averaged over all threads of the same role.
+// note: the latencies include the overhead of reading the clock twice
+//       (a few 10 ns), so compare them relative to each other
+//
+// use e.g. --benchmark_filter='ExchangeBuffer<64>' to select a subset
+
+constexpr uint32_t CAPACITY = 32;
+constexpr uint64_t LATENCY_SAMPLE_INTERVAL = 8;
+constexpr size_t MAX_LATENCY_SAMPLES = 1 << 20;
+
+template <size_t Size> struct Payload {
+  static_assert(Size > sizeof(uint64_t));
+  uint64_t value;
+  uint8_t data[Size - sizeof(uint64_t)];
+};
+
+// no zero-length array (not ISO C++)
+template <> struct Payload<sizeof(uint64_t)> {
+  uint64_t value;
+};
+
+// operations
+
+struct Write {
+  static constexpr const char *name = "write";
+  template <class Buffer, class T> static bool run(Buffer &buffer, T &value) {
+    return buffer.write(value);
+  }
+};
+
+struct TryWrite {
+  static constexpr const char *name = "try_write";
+  template <class Buffer, class T> static bool run(Buffer &buffer, T &value) {
+    return buffer.try_write(value);
+  }
+};
+
+struct Take {
+  static constexpr const char *name = "take";
+  template <class Buffer, class T> static bool run(Buffer &buffer, T &value) {
+    auto result = buffer.take();
+    if (result) {
+      value = *result;
+      return true;
+    }
+    return false;
+  }
+};
+
+struct Read {
+  static constexpr const char *name = "read";
+  template <class Buffer, class T> static bool run(Buffer &buffer, T &value) {
+    auto result = buffer.read();
+    if (result) {
+      value = *result;
+      return true;
+    }
+    return false;
+  }
+};
+
+// latency recording
+
+class LatencySamples {
+public:
+  LatencySamples() { m_samples.reserve(MAX_LATENCY_SAMPLES); }
+
+  void add(uint64_t ns) {
+    if (m_samples.size() == MAX_LATENCY_SAMPLES) {
+      // keep every other sample and record only half as often from now on
+      for (size_t i = 0; i < m_samples.size() / 2; ++i) {
+        m_samples[i] = m_samples[2 * i];
+      }
+      m_samples.resize(m_samples.size() / 2);
+      m_stride *= 2;
+    }
+    if (++m_skipped >= m_stride) {
+      m_skipped = 0;
+      m_samples.push_back(ns);
+    }
+  }
+
+  double percentile(double p) {
+    if (m_samples.empty()) {
+      return 0;
+    }
+    auto n = static_cast<size_t>(p * (m_samples.size() - 1));
+    std::nth_element(m_samples.begin(), m_samples.begin() + n,
+                     m_samples.end());
+    return static_cast<double>(m_samples[n]);
+  }
+
+private:
+  std::vector<uint64_t> m_samples;
+  uint64_t m_stride{1};
+  uint64_t m_skipped{0};
+};
+
+// benchmark
+
+template <class Buffer> std::unique_ptr<Buffer> g_buffer;
+
+template <class Buffer> void setup(const benchmark::State &) {
+  g_buffer<Buffer> = std::make_unique<Buffer>();
+}
+
+template <class Buffer> void teardown(const benchmark::State &) {
+  g_buffer<Buffer>.reset();
+}
+
+template <class Buffer, class T, class ProducerOp, class ConsumerOp>
+void buffer_ops(benchmark::State &state) {
+  using clock = std::chrono::steady_clock;
+
+  auto &buffer = *g_buffer<Buffer>;
+  const auto numProducers = state.range(0);
+  const auto numConsumers = state.threads() - numProducers;
+  const bool isProducer = state.thread_index() < numProducers;
+
+  T value{};
+  value.value = state.thread_index();
+  LatencySamples latencies;
+  uint64_t numOps = 0;
+  uint64_t numSuccessful = 0;
+
+  for (auto _ : state) {
+    bool success;
+    if (numOps++ % LATENCY_SAMPLE_INTERVAL == 0) {
+      auto start = clock::now();
+      success = isProducer ? ProducerOp::run(buffer, value)
+                           : ConsumerOp::run(buffer, value);
+      auto end = clock::now();
+      latencies.add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+              .count());
+    } else {
+      success = isProducer ? ProducerOp::run(buffer, value)
+                           : ConsumerOp::run(buffer, value);
+    }
+    numSuccessful += success;
+    benchmark::DoNotOptimize(value);
+  }
+
+  // counters are summed over the threads, hence we divide by the number of
+  // threads of the role to obtain averages
+  const std::string role = isProducer ? ProducerOp::name : ConsumerOp::name;
+  const double roleThreads = isProducer ? numProducers : numConsumers;
+  auto &counters = state.counters;
+  counters[role + "_ops"] =
+      benchmark::Counter(numOps, benchmark::Counter::kIsRate);
+  counters[role + "_success"] = numSuccessful / (numOps * roleThreads);
+  counters[role + "_p50_ns"] = latencies.percentile(0.5) / roleThreads;
+  counters[role + "_p99_ns"] = latencies.percentile(0.99) / roleThreads;
+  counters[role + "_p999_ns"] = latencies.percentile(0.999) / roleThreads;
+}
+
+// producer/consumer thread configurations
+struct Threads {
+  int producers;
+  int consumers;
+};
+
+constexpr Threads THREAD_CONFIGS[] = {{1, 0}, {2, 0}, {4, 0}, {8, 0},
+                                      {0, 1}, {0, 4}, {1, 1}, {1, 3},
+                                      {3, 1}, {2, 2}, {1, 7}, {4, 4}};
+
+// spsc: the buffer supports at most one producer and one consumer thread
+template <class Buffer, class T, class ProducerOp, class ConsumerOp>
+void register_ops(const std::string &bufferName, bool spsc = false) {
+  auto name = bufferName + "<" + std::to_string(sizeof(T)) + ">/" +
+              ProducerOp::name + "-" + ConsumerOp::name;
+  for (auto threads : THREAD_CONFIGS) {
+    if (spsc && (threads.producers > 1 || threads.consumers > 1)) {
+      continue;
+    }
+    benchmark::RegisterBenchmark(name.c_str(),
+                                 buffer_ops<Buffer, T, ProducerOp, ConsumerOp>)
+        ->Setup(setup<Buffer>)
+        ->Teardown(teardown<Buffer>)
+        ->Arg(threads.producers)
+        ->Threads(threads.producers + threads.consumers)
+        ->UseRealTime();
+  }
+}
+
+template <class T> void register_payload() {
+  using LockFreeExchangeBuffer = lockfree::ExchangeBuffer<T, CAPACITY>;
+  using LockFreeTakeBuffer = lockfree::TakeBuffer<T, CAPACITY>;
+  using SpscExchangeBuffer = lockfree::SpscExchangeBuffer<T>;
+  using SpscTakeBuffer = lockfree::SpscTakeBuffer<T>;
+  using NotLockFreeExchangeBuffer = not_lockfree::ExchangeBuffer<T, CAPACITY>;
+  using NotLockFreeTakeBuffer = not_lockfree::TakeBuffer<T>;
+
+  register_ops<LockFreeExchangeBuffer, T, Write, Read>(
+      "lockfree::ExchangeBuffer");
+  register_ops<LockFreeExchangeBuffer, T, Write, Take>(
+      "lockfree::ExchangeBuffer");
+  register_ops<LockFreeExchangeBuffer, T, TryWrite, Take>(
+      "lockfree::ExchangeBuffer");
+
+  register_ops<LockFreeTakeBuffer, T, Write, Take>("lockfree::TakeBuffer");
+  register_ops<LockFreeTakeBuffer, T, TryWrite, Take>("lockfree::TakeBuffer");
+
+  register_ops<SpscExchangeBuffer, T, Write, Read>(
+      "lockfree::SpscExchangeBuffer", true);
+  register_ops<SpscExchangeBuffer, T, Write, Take>(
+      "lockfree::SpscExchangeBuffer", true);
+  register_ops<SpscExchangeBuffer, T, TryWrite, Take>(
+      "lockfree::SpscExchangeBuffer", true);
+
+  register_ops<SpscTakeBuffer, T, Write, Take>("lockfree::SpscTakeBuffer",
+                                               true);
+  register_ops<SpscTakeBuffer, T, TryWrite, Take>("lockfree::SpscTakeBuffer",
+                                                  true);
+
+  register_ops<NotLockFreeExchangeBuffer, T, Write, Read>(
+      "not_lockfree::ExchangeBuffer");
+  register_ops<NotLockFreeExchangeBuffer, T, Write, Take>(
+      "not_lockfree::ExchangeBuffer");
+  register_ops<NotLockFreeExchangeBuffer, T, TryWrite, Take>(
+      "not_lockfree::ExchangeBuffer");
+
+  register_ops<NotLockFreeTakeBuffer, T, Write, Take>(
+      "not_lockfree::TakeBuffer");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  register_payload<Payload<8>>();
+  register_payload<Payload<64>>();
+  register_payload<Payload<512>>();
+  register_payload<Payload<4096>>();
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
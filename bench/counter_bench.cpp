@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+
+#include "lockfree/dwcas_sync_counter.hpp"
+#include "lockfree/sharded_counter.hpp"
+#include "lockfree/sync_counter.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace {
+
+// Throughput (increments/s) of the counters depending on the number of
+// threads (1 to 64) incrementing the same counter.
+//
+// std::atomic is a single fetch_add on one cache line, the SyncCounter a CAS
+// loop on two cache lines (helping), the DwcasSyncCounter a 16 byte CAS loop
+// and the ShardedCounter increments per thread shards.
+//
+// The sync benchmarks measure the latency of reading a consistent value while
+// the other threads increment (threads:1 is the uncontended latency).
+
+struct Atomic {
+  std::atomic<uint64_t> count{0};
+  void increment() { count.fetch_add(1, std::memory_order_relaxed); }
+};
+
+template <class Counter> void increment(benchmark::State &state) {
+  static Counter counter;
+  for (auto _ : state) {
+    counter.increment();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// thread 0 syncs, all others increment
+template <class Counter> void sync(benchmark::State &state) {
+  static Counter counter;
+  for (auto _ : state) {
+    if (state.thread_index() == 0) {
+      benchmark::DoNotOptimize(counter.sync());
+    } else {
+      counter.increment();
+    }
+  }
+}
+
+#define COUNTER_BENCHMARK(counter)                                             \
+  BENCHMARK_TEMPLATE(increment, counter)->ThreadRange(1, 64)->UseRealTime()
+
+COUNTER_BENCHMARK(Atomic);
+COUNTER_BENCHMARK(lockfree::SyncCounter);
+COUNTER_BENCHMARK(lockfree::ShardedCounter<>);
+COUNTER_BENCHMARK(lockfree::ShardedCounter<lockfree::SyncCounter>);
+#if LOCKFREE_HAS_DWCAS
+COUNTER_BENCHMARK(lockfree::DwcasSyncCounter);
+#endif
+
+BENCHMARK_TEMPLATE(sync, lockfree::SyncCounter)->ThreadRange(1, 8);
+#if LOCKFREE_HAS_DWCAS
+BENCHMARK_TEMPLATE(sync, lockfree::DwcasSyncCounter)->ThreadRange(1, 8);
+#endif
+
+} // namespace
+
+BENCHMARK_MAIN();
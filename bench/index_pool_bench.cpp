@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+
+#include "lockfree/cached_index_pool.hpp"
+#include "lockfree/free_list_index_pool.hpp"
+#include "lockfree/index_pool.hpp"
+
+#include <memory>
+
+namespace {
+
+// Measures the latency of a get/free pair depending on the pool size and the
+// number of concurrent threads.
+//
+// The pool is filled up to all but MAX_THREADS indices before the benchmark
+// runs. This is the typical situation of a buffer where most slots are in use
+// and models the worst case for the linear scan of IndexPool, which then
+// has to pass all used slots to find a free one.
+
+constexpr int MAX_THREADS = 8;
+
+template <class Pool> std::unique_ptr<Pool> g_pool;
+
+template <class Pool> void setup(const benchmark::State &) {
+  g_pool<Pool> = std::make_unique<Pool>();
+  for (uint32_t i = 0; i < Pool::CAPACITY - MAX_THREADS; ++i) {
+    g_pool<Pool>->get();
+  }
+}
+
+template <class Pool> void teardown(const benchmark::State &) {
+  g_pool<Pool>.reset();
+}
+
+// the first benchmark thread is the main thread which outlives the pool,
+// hence it must return its cached indices explicitly
+template <class Pool> void flush(Pool &) {}
+
+template <uint32_t Size, class IndexPoolType, uint32_t MagazineSize>
+void flush(lockfree::CachedIndexPool<Size, IndexPoolType, MagazineSize> &pool) {
+  pool.flush();
+}
+
+template <class Pool> void get_free(benchmark::State &state) {
+  auto &pool = *g_pool<Pool>;
+  for (auto _ : state) {
+    auto index = pool.get();
+    benchmark::DoNotOptimize(index);
+    if (index) {
+      pool.free(*index);
+    }
+  }
+  flush(pool);
+  state.SetItemsProcessed(state.iterations());
+}
+
+#define INDEX_POOL_BENCHMARK(Pool)                                             \
+  BENCHMARK_TEMPLATE(get_free, Pool)                                           \
+      ->Setup(setup<Pool>)                                                     \
+      ->Teardown(teardown<Pool>)                                               \
+      ->ThreadRange(1, MAX_THREADS)                                            \
+      ->UseRealTime()
+
+INDEX_POOL_BENCHMARK(lockfree::IndexPool<16>);
+INDEX_POOL_BENCHMARK(lockfree::IndexPool<64>);
+INDEX_POOL_BENCHMARK(lockfree::IndexPool<256>);
+INDEX_POOL_BENCHMARK(lockfree::IndexPool<1024>);
+INDEX_POOL_BENCHMARK(lockfree::FreeListIndexPool<16>);
+INDEX_POOL_BENCHMARK(lockfree::FreeListIndexPool<64>);
+INDEX_POOL_BENCHMARK(lockfree::FreeListIndexPool<256>);
+INDEX_POOL_BENCHMARK(lockfree::FreeListIndexPool<1024>);
+INDEX_POOL_BENCHMARK(lockfree::CachedIndexPool<64>);
+INDEX_POOL_BENCHMARK(lockfree::CachedIndexPool<1024>);
+
+} // namespace
+
+BENCHMARK_MAIN();
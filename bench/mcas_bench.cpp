@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include "lockfree/layout.hpp"
+#include "lockfree/mcas.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace {
+
+// Throughput of incrementing k words (Arg, 2 to 8) atomically with an MCAS
+// compared to incrementing them under a mutex, for 1 to 8 threads operating
+// on the same words (each word in its own cache line).
+
+constexpr uint32_t MAX_WORDS = 8;
+
+template <class T> struct alignas(lockfree::CACHE_LINE_SIZE) Padded {
+  T value{0};
+};
+
+using MCas = lockfree::MCas<MAX_WORDS>;
+
+void mcas_increment(benchmark::State &state) {
+  static MCas mcas;
+  static Padded<MCas::word_t> words[MAX_WORDS];
+  const auto k = state.range(0);
+  MCas::Entry entries[MAX_WORDS];
+  for (auto _ : state) {
+    do {
+      for (int i = 0; i < k; ++i) {
+        auto &word = words[i].value;
+        auto value = mcas.read(word);
+        entries[i] = {&word, value, value + 1};
+      }
+    } while (!mcas.cas(entries, entries + k));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void mutex_increment(benchmark::State &state) {
+  static std::mutex mutex;
+  static Padded<uint64_t> words[MAX_WORDS];
+  const auto k = state.range(0);
+  for (auto _ : state) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < k; ++i) {
+      ++words[i].value;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(mcas_increment)->DenseRange(2, MAX_WORDS)->ThreadRange(1, 8);
+BENCHMARK(mutex_increment)->DenseRange(2, MAX_WORDS)->ThreadRange(1, 8);
+
+} // namespace
+
+BENCHMARK_MAIN();
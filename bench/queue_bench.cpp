@@ -0,0 +1,161 @@
+#include <benchmark/benchmark.h>
+
+#include "lockfree/free_list_index_pool.hpp"
+#include "lockfree/queue.hpp"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+
+namespace {
+
+// Throughput of lockfree::Queue compared to a std::queue protected by a
+// std::mutex (with the same capacity) for different numbers of producers and
+// consumers. Threads with index < number of producers push, the others pop.
+
+constexpr uint32_t CAPACITY = 256;
+constexpr uint32_t BATCH_SIZE = 16;
+
+template <class T, uint32_t C> class MutexQueue {
+public:
+  bool try_push(const T &value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.size() >= C) {
+      return false;
+    }
+    m_queue.push(value);
+    return true;
+  }
+
+  std::optional<T> try_pop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.empty()) {
+      return std::nullopt;
+    }
+    std::optional<T> ret(std::move(m_queue.front()));
+    m_queue.pop();
+    return ret;
+  }
+
+  uint32_t try_push_batch(const T *values, uint32_t n) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t i = 0;
+    for (; i < n && m_queue.size() < C; ++i) {
+      m_queue.push(values[i]);
+    }
+    return i;
+  }
+
+  uint32_t try_pop_batch(T *values, uint32_t n) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t i = 0;
+    for (; i < n && !m_queue.empty(); ++i) {
+      values[i] = std::move(m_queue.front());
+      m_queue.pop();
+    }
+    return i;
+  }
+
+private:
+  std::mutex m_mutex;
+  std::queue<T> m_queue;
+};
+
+// the linear scan of the default IndexPool dominates for large capacities
+using LockFreeQueue =
+    lockfree::Queue<uint64_t, CAPACITY, lockfree::FreeListIndexPool<CAPACITY>>;
+using BaselineQueue = MutexQueue<uint64_t, CAPACITY>;
+
+template <class Queue> std::unique_ptr<Queue> g_queue;
+
+template <class Queue> void setup(const benchmark::State &) {
+  g_queue<Queue> = std::make_unique<Queue>();
+}
+
+template <class Queue> void teardown(const benchmark::State &) {
+  g_queue<Queue>.reset();
+}
+
+template <class Queue> void push_pop(benchmark::State &state) {
+  auto &queue = *g_queue<Queue>;
+  const bool isProducer = state.thread_index() < state.range(0);
+  uint64_t numTransferred = 0;
+  uint64_t value = 0;
+
+  for (auto _ : state) {
+    if (isProducer) {
+      numTransferred += queue.try_push(++value);
+    } else {
+      auto result = queue.try_pop();
+      numTransferred += result.has_value();
+      benchmark::DoNotOptimize(result);
+    }
+  }
+
+  state.counters["transferred"] =
+      benchmark::Counter(numTransferred, benchmark::Counter::kIsRate);
+}
+
+template <class Queue> void push_pop_batch(benchmark::State &state) {
+  auto &queue = *g_queue<Queue>;
+  const bool isProducer = state.thread_index() < state.range(0);
+  uint64_t numTransferred = 0;
+  uint64_t values[BATCH_SIZE] = {};
+
+  for (auto _ : state) {
+    if (isProducer) {
+      numTransferred += queue.try_push_batch(values, BATCH_SIZE);
+    } else {
+      numTransferred += queue.try_pop_batch(values, BATCH_SIZE);
+      benchmark::DoNotOptimize(values);
+    }
+  }
+
+  state.counters["transferred"] =
+      benchmark::Counter(numTransferred, benchmark::Counter::kIsRate);
+}
+
+// producer/consumer thread configurations
+struct Threads {
+  int producers;
+  int consumers;
+};
+
+constexpr Threads THREAD_CONFIGS[] = {{1, 1}, {1, 3}, {3, 1}, {2, 2}, {4, 4}};
+
+template <class Queue>
+void register_queue(const std::string &queueName) {
+  for (auto threads : THREAD_CONFIGS) {
+    benchmark::RegisterBenchmark((queueName + "/push-pop").c_str(),
+                                 push_pop<Queue>)
+        ->Setup(setup<Queue>)
+        ->Teardown(teardown<Queue>)
+        ->Arg(threads.producers)
+        ->Threads(threads.producers + threads.consumers)
+        ->UseRealTime();
+    benchmark::RegisterBenchmark((queueName + "/push-pop-batch").c_str(),
+                                 push_pop_batch<Queue>)
+        ->Setup(setup<Queue>)
+        ->Teardown(teardown<Queue>)
+        ->Arg(threads.producers)
+        ->Threads(threads.producers + threads.consumers)
+        ->UseRealTime();
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  register_queue<LockFreeQueue>("LockFreeQueue");
+  register_queue<BaselineQueue>("MutexQueue");
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
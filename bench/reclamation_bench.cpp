@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include "lockfree/pointer_exchange_buffer.hpp"
+#include "lockfree/reclamation.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace {
+
+// Cost of safe memory reclamation with hazard pointers and epochs:
+// - protect: guard and load a shared pointer (read side overhead)
+// - retire: allocate, retire and eventually delete an object compared to a
+//   plain delete (the amortized cost of the scans is included)
+// - PointerExchangeBuffer: write and read from 1 to 16 threads, half of the
+//   threads write and half read
+
+using lockfree::EpochDomain;
+using lockfree::HazardPointerDomain;
+
+using HP = HazardPointerDomain<>;
+using Epoch = EpochDomain<>;
+
+struct Value {
+  uint64_t data[4]{};
+};
+
+std::atomic<Value *> shared{new Value};
+
+void plain_load(benchmark::State &state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(shared.load(std::memory_order_acquire)->data[0]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <class Domain> void protect(benchmark::State &state) {
+  auto &domain = Domain::global();
+  for (auto _ : state) {
+    auto guard = domain.guard();
+    benchmark::DoNotOptimize(guard.protect(shared)->data[0]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void plain_delete(benchmark::State &state) {
+  for (auto _ : state) {
+    auto ptr = new Value;
+    benchmark::DoNotOptimize(ptr);
+    delete ptr;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <class Domain> void retire(benchmark::State &state) {
+  auto &domain = Domain::global();
+  for (auto _ : state) {
+    auto ptr = new Value;
+    benchmark::DoNotOptimize(ptr);
+    domain.retire(ptr);
+  }
+  domain.reclaim();
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <class Domain> void write_read(benchmark::State &state) {
+  static lockfree::PointerExchangeBuffer<Value, Domain> buffer;
+  Value value;
+  const bool writer = state.thread_index() % 2 == 0;
+  for (auto _ : state) {
+    if (writer) {
+      buffer.write(value);
+    } else {
+      benchmark::DoNotOptimize(buffer.read());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(plain_load)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(protect, HP)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(protect, Epoch)->ThreadRange(1, 16);
+BENCHMARK(plain_delete)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(retire, HP)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(retire, Epoch)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(write_read, HP)->ThreadRange(2, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(write_read, Epoch)->ThreadRange(2, 16)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
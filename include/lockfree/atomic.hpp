@@ -0,0 +1,29 @@
+#pragma once
+
+// The atomic type of the data structures: std::atomic, or the instrumented
+// atomic of the model checker if LOCKFREE_MODEL_CHECK is defined (for all
+// translation units, cf. lockfree/model_check.hpp).
+
+#include <atomic>
+
+#ifdef LOCKFREE_MODEL_CHECK
+#include "lockfree/model_check.hpp"
+#endif
+
+namespace lockfree {
+
+#ifdef LOCKFREE_MODEL_CHECK
+template <class T> using atomic = model::atomic<T>;
+
+inline void thread_fence(std::memory_order order) {
+  model::atomic_thread_fence(order);
+}
+#else
+template <class T> using atomic = std::atomic<T>;
+
+inline void thread_fence(std::memory_order order) {
+  std::atomic_thread_fence(order);
+}
+#endif
+
+} // namespace lockfree
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace lockfree {
+
+// Backoff policies for CAS retry loops.
+// A policy object is created per operation and backoff() is called after each
+// failed attempt, i.e. policies can adapt to the number of failures.
+// Backing off reduces the coherence traffic on contended cache lines (at the
+// cost of latency if there is little contention).
+
+// hint to the CPU that we are spinning (e.g. to save power and to free
+// resources for the other hyperthread)
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#else
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// retry immediately
+struct NoBackoff {
+  void backoff() {}
+};
+
+// spin for an exponentially growing number of iterations (up to MaxSpins)
+template <uint32_t MinSpins = 4, uint32_t MaxSpins = 1024>
+class ExponentialBackoff {
+public:
+  static_assert(MinSpins > 0 && MinSpins <= MaxSpins);
+
+  void backoff() {
+    for (uint32_t i = 0; i < m_spins; ++i) {
+      cpu_relax();
+    }
+    if (m_spins < MaxSpins) {
+      m_spins = 2 * m_spins < MaxSpins ? 2 * m_spins : MaxSpins;
+    }
+  }
+
+private:
+  uint32_t m_spins{MinSpins};
+};
+
+// back off exponentially for SpinRounds failures and yield the CPU afterwards
+// (useful if there are more threads than cores, where a preempted thread may
+// block the progress of the spinning ones)
+template <uint32_t SpinRounds = 6, uint32_t MinSpins = 4,
+          uint32_t MaxSpins = 1024>
+class SpinThenYieldBackoff {
+public:
+  void backoff() {
+    if (m_rounds < SpinRounds) {
+      ++m_rounds;
+      m_spin.backoff();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+private:
+  uint32_t m_rounds{0};
+  ExponentialBackoff<MinSpins, MaxSpins> m_spin;
+};
+
+} // namespace lockfree
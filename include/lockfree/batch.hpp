@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace lockfree {
+
+// Batched operations for the latest-value buffers (ExchangeBuffer,
+// TakeBuffer and their SPSC variants).
+
+// Write a batch of updates [first, last) to the buffer.
+// Only the last value needs to be published since it would overwrite the
+// previous ones anyway, i.e. the batch costs a single slot allocation and
+// publication instead of one per value (the other values are not copied).
+// returns false if the range is empty or the write failed
+template <class Buffer, class ForwardIt>
+bool write_batch(Buffer &buffer, ForwardIt first, ForwardIt last) {
+  if (first == last) {
+    return false;
+  }
+
+  using category = typename std::iterator_traits<ForwardIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::bidirectional_iterator_tag, category>) {
+    return buffer.write(*std::prev(last));
+  } else {
+    auto latest = first;
+    for (++first; first != last; ++first) {
+      latest = first;
+    }
+    return buffer.write(*latest);
+  }
+}
+
+// Take the values of all buffers in the range and call consume(i, value) for
+// the i-th buffer if it contained a value.
+// The buffers are first checked with plain loads (which can be in flight
+// concurrently), only the buffers which contained a value are taken with an
+// atomic read-modify-write operation afterwards.
+// Buffers may be elements of the range or pointers to them.
+// returns the number of values taken
+//
+// note: the values are not taken atomically, i.e. a buffer which was empty
+//       in the first pass is skipped even if it is written concurrently
+template <class Range, class Consumer>
+size_t take_all(Range &&buffers, Consumer &&consume) {
+  constexpr size_t CHUNK_SIZE = 64;
+
+  auto deref = [](auto &buffer) -> auto & {
+    if constexpr (std::is_pointer_v<std::decay_t<decltype(buffer)>>) {
+      return *buffer;
+    } else {
+      return buffer;
+    }
+  };
+
+  size_t numTaken = 0;
+  size_t index = 0;
+  auto it = std::begin(buffers);
+  auto end = std::end(buffers);
+
+  while (it != end) {
+    // first pass over a chunk: check for values
+    bool hasValue[CHUNK_SIZE];
+    auto chunkBegin = it;
+    size_t n = 0;
+    for (; n < CHUNK_SIZE && it != end; ++n, ++it) {
+      hasValue[n] = !deref(*it).empty();
+    }
+
+    // second pass: take the values
+    it = chunkBegin;
+    for (size_t i = 0; i < n; ++i, ++it, ++index) {
+      if (!hasValue[i]) {
+        continue;
+      }
+      if (auto value = deref(*it).take()) {
+        consume(index, std::move(*value));
+        ++numTaken;
+      }
+    }
+  }
+
+  return numTaken;
+}
+
+} // namespace lockfree
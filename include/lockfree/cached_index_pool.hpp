@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "lockfree/free_list_index_pool.hpp"
+
+namespace lockfree {
+
+namespace detail {
+
+// ids of the live CachedIndexPools (of all types). A pool can be destroyed
+// while other threads still cache its indices, their magazines then refer to
+// freed memory (or to a new pool at the same address) and are only drained
+// if the id of their pool is still live. Only used when a pool is created or
+// destroyed, when a thread exits and when all magazines of a thread are in
+// use, i.e. not by get and free.
+struct CachedPoolRegistry {
+  std::mutex mutex;
+  std::vector<uint64_t> live;
+  uint64_t nextId{1};
+  // number of destroyed pools, threads look for stale magazines only if it
+  // changed
+  std::atomic<uint64_t> destroyed{0};
+
+  static CachedPoolRegistry &instance() {
+    static CachedPoolRegistry registry;
+    return registry;
+  }
+
+  uint64_t add() {
+    std::lock_guard<std::mutex> lock(mutex);
+    live.push_back(nextId);
+    return nextId++;
+  }
+
+  void remove(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    live.erase(std::find(live.begin(), live.end(), id));
+    destroyed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // requires the lock
+  bool alive(uint64_t id) const {
+    return std::find(live.begin(), live.end(), id) != live.end();
+  }
+};
+
+} // namespace detail
+
+// Per-thread cache (magazine) of free indices in front of an index pool.
+//
+// Each thread keeps up to MagazineSize free indices locally and only refills
+// from or flushes to the shared pool in batches. Most get/free calls hence do
+// not touch any shared cache line.
+//
+// note: up to MagazineSize indices per thread can be cached and are not
+//       available to other threads, i.e. the capacity should be chosen large
+//       enough (Size >= (number of threads) * MagazineSize + indices in use)
+//
+// note: the cached indices of a thread are returned to the pool when the thread
+//       exits, when it calls flush or when it destroys the pool. The indices
+//       other threads still cache when the pool is destroyed are dropped
+//       (each pool has a unique id, cf. detail::CachedPoolRegistry).
+template <uint32_t Size, class IndexPoolType = FreeListIndexPool<Size>,
+          uint32_t MagazineSize = 4>
+class CachedIndexPool {
+public:
+  using index_t = typename IndexPoolType::index_t;
+
+  static constexpr uint32_t CAPACITY = Size;
+
+private:
+  // number of pools of this type a thread can cache indices for,
+  // additional pools are used without cache
+  static constexpr uint32_t MAX_POOLS_PER_THREAD = 4;
+
+  // transfer half of the magazine to amortize the access of the shared pool,
+  // but do not immediately run empty (full) again after a flush (refill)
+  static constexpr uint32_t BATCH_SIZE =
+      MagazineSize > 1 ? MagazineSize / 2 : 1;
+
+  static_assert(IndexPoolType::CAPACITY == Size);
+  static_assert(MagazineSize > 0 && MagazineSize <= Size);
+
+  struct Magazine {
+    CachedIndexPool *owner{nullptr};
+    // id of the owner, the owner may be destroyed and its address reused
+    uint64_t ownerId{0};
+    uint32_t count{0};
+    index_t indices[MagazineSize];
+  };
+
+  struct ThreadCache {
+    Magazine magazines[MAX_POOLS_PER_THREAD];
+    // number of destroyed pools when we last dropped stale magazines
+    uint64_t destroyed{0};
+
+    // drain the magazines of live pools when the thread exits
+    ~ThreadCache() {
+      auto &registry = detail::CachedPoolRegistry::instance();
+      // the lock keeps the pools from being destroyed while we drain
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for (auto &magazine : magazines) {
+        if (magazine.owner && registry.alive(magazine.ownerId)) {
+          magazine.owner->release(magazine);
+        }
+      }
+    }
+
+    // drop the magazines of destroyed pools (without draining them)
+    void drop_stale() {
+      auto &registry = detail::CachedPoolRegistry::instance();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for (auto &magazine : magazines) {
+        if (magazine.owner && !registry.alive(magazine.ownerId)) {
+          magazine = Magazine();
+        }
+      }
+      destroyed = registry.destroyed.load(std::memory_order_relaxed);
+    }
+  };
+
+public:
+  CachedIndexPool() : m_id(detail::CachedPoolRegistry::instance().add()) {}
+
+  CachedIndexPool(const CachedIndexPool &) = delete;
+  CachedIndexPool &operator=(const CachedIndexPool &) = delete;
+
+  ~CachedIndexPool() {
+    // exiting threads do not drain their magazines into us anymore
+    detail::CachedPoolRegistry::instance().remove(m_id);
+    flush();
+  }
+
+  std::optional<index_t> get() {
+    auto magazine = local_magazine();
+    if (!magazine) {
+      return m_pool.get();
+    }
+
+    if (magazine->count == 0) {
+      refill(*magazine);
+      if (magazine->count == 0) {
+        return std::nullopt; // shared pool is exhausted as well
+      }
+    }
+
+    return magazine->indices[--magazine->count];
+  }
+
+  void free(index_t index) {
+    auto magazine = local_magazine();
+    if (!magazine) {
+      m_pool.free(index);
+      return;
+    }
+
+    if (magazine->count == MagazineSize) {
+      drain(*magazine, BATCH_SIZE);
+    }
+
+    magazine->indices[magazine->count++] = index;
+  }
+
+  // return all indices cached by the calling thread to the shared pool
+  void flush() {
+    for (auto &magazine : thread_cache().magazines) {
+      if (magazine.owner == this && magazine.ownerId == m_id) {
+        release(magazine);
+      }
+    }
+  }
+
+private:
+  IndexPoolType m_pool;
+  uint64_t m_id;
+
+  static ThreadCache &thread_cache() {
+    thread_local ThreadCache cache;
+    return cache;
+  }
+
+  Magazine *local_magazine() {
+    auto &cache = thread_cache();
+    auto magazine = find_magazine(cache);
+    if (!magazine) {
+      // the magazines may belong to pools destroyed in the meantime
+      auto &registry = detail::CachedPoolRegistry::instance();
+      if (cache.destroyed ==
+          registry.destroyed.load(std::memory_order_relaxed)) {
+        return nullptr;
+      }
+      cache.drop_stale();
+      magazine = find_magazine(cache);
+      if (!magazine) {
+        return nullptr;
+      }
+    }
+
+    if (!magazine->owner) {
+      magazine->owner = this;
+      magazine->ownerId = m_id;
+    }
+    return magazine;
+  }
+
+  // the magazine of this pool or else an unused one (nullptr if none)
+  Magazine *find_magazine(ThreadCache &cache) {
+    Magazine *unused = nullptr;
+    for (auto &magazine : cache.magazines) {
+      if (magazine.owner == this) {
+        if (magazine.ownerId == m_id) {
+          return &magazine;
+        }
+        // of a destroyed pool at the same address, the indices are not ours
+        magazine = Magazine();
+      }
+      if (!unused && !magazine.owner) {
+        unused = &magazine;
+      }
+    }
+    return unused;
+  }
+
+  void refill(Magazine &magazine) {
+    while (magazine.count < BATCH_SIZE) {
+      auto index = m_pool.get();
+      if (!index) {
+        break;
+      }
+      magazine.indices[magazine.count++] = *index;
+    }
+  }
+
+  void drain(Magazine &magazine, uint32_t n) {
+    for (; n > 0 && magazine.count > 0; --n) {
+      m_pool.free(magazine.indices[--magazine.count]);
+    }
+  }
+
+  void release(Magazine &magazine) {
+    drain(magazine, MagazineSize);
+    magazine.owner = nullptr;
+  }
+};
+
+} // namespace lockfree
@@ -1,39 +1,175 @@
 #pragma once
 
 #include <atomic>
+#include <limits>
+#include <type_traits>
+
+#include "lockfree/backoff.hpp"
 
 namespace lockfree {
 
-template <class T>
-bool compare_exchange_if_not_equal(std::atomic<T> &location, const T &expected,
-                                   const T &newValue) {
-  auto value = location.load();
+// order is the memory order of a successful exchange (like for the RMW
+// operations of std::atomic), the loads are relaxed since we do not depend on
+// values we did not exchange
+// Backoff is applied after each failed exchange (cf. backoff.hpp)
+template <class Backoff = NoBackoff, class T>
+bool compare_exchange_if_not_equal(
+    std::atomic<T> &location, const T &expected, const T &newValue,
+    std::memory_order order = std::memory_order_seq_cst) {
+  Backoff backoff;
+  auto value = location.load(std::memory_order_relaxed);
 
   while (value != expected) {
-    if (location.compare_exchange_strong(value, newValue)) {
+    // a spurious failure just reloads value and retries
+    if (location.compare_exchange_weak(value, newValue, order,
+                                       std::memory_order_relaxed)) {
       // we exchanged since the value did not match the expected one
       return true;
     }
     // value contains the updated value
+    backoff.backoff();
   }
 
   // value matched expected, do not exchange
   return false;
 }
 
-int fetch_multiply(std::atomic<int> &value, int multiplier) {
-  int oldValue = value.load();
+namespace detail {
+// prevents deduction of T from arguments other than the atomic
+template <class T> struct identity {
+  using type = T;
+};
+template <class T> using non_deduced_t = typename identity<T>::type;
+} // namespace detail
+
+// fetch_update family: atomically replace the value with f(value) and return
+// the previous value (like fetch_add, but for arbitrary updates)
+//
+// order is the memory order of a successful exchange, the operations that do
+// not exchange (e.g. fetch_max with a smaller value) only perform a relaxed
+// load (cf. compare_exchange_if_not_equal)
+// Backoff is applied after each failed exchange (cf. backoff.hpp)
+// if there is a native instruction for an update it is used instead of the
+// CAS loop (decided at compile time)
+
+template <class Backoff = NoBackoff, class T, class F>
+T fetch_update(std::atomic<T> &location, F &&f,
+               std::memory_order order = std::memory_order_seq_cst) {
+  Backoff backoff;
+  T oldValue = location.load(std::memory_order_relaxed);
 
   do {
     // local computation of new value
-    int newValue{oldValue * multiplier};
-    if (value.compare_exchange_strong(oldValue, newValue)) {
+    T newValue = f(oldValue);
+    if (location.compare_exchange_weak(oldValue, newValue, order,
+                                       std::memory_order_relaxed)) {
       break;
     }
     // concurrent update occurred, retry until success
+    backoff.backoff();
   } while (true);
 
   return oldValue;
 }
 
+// like fetch_update but only exchanges while pred(value) holds, i.e. values
+// that would not change are not written (avoids the exclusive access to the
+// cache line)
+template <class Backoff = NoBackoff, class T, class P, class F>
+T fetch_update_if(std::atomic<T> &location, P &&pred, F &&f,
+                  std::memory_order order = std::memory_order_seq_cst) {
+  Backoff backoff;
+  T oldValue = location.load(std::memory_order_relaxed);
+
+  while (pred(oldValue)) {
+    if (location.compare_exchange_weak(oldValue, f(oldValue), order,
+                                       std::memory_order_relaxed)) {
+      break;
+    }
+    backoff.backoff();
+  }
+
+  return oldValue;
+}
+
+// note: overflows are undefined for signed integers (as for operator*)
+template <class Backoff = NoBackoff, class T>
+T fetch_multiply(std::atomic<T> &location,
+                 detail::non_deduced_t<T> multiplier,
+                 std::memory_order order = std::memory_order_seq_cst) {
+  if constexpr (std::is_integral_v<T>) {
+    if (multiplier == T(0)) {
+      // the result does not depend on the old value
+      // (not for floating point: NaN, inf and the sign of zero)
+      return location.exchange(T(0), order);
+    }
+  }
+  return fetch_update<Backoff>(
+      location, [=](T value) { return value * multiplier; }, order);
+}
+
+template <class Backoff = NoBackoff, class T>
+T fetch_max(std::atomic<T> &location, detail::non_deduced_t<T> value,
+            std::memory_order order = std::memory_order_seq_cst) {
+  return fetch_update_if<Backoff>(
+      location, [=](T current) { return current < value; },
+      [=](T) { return value; }, order);
+}
+
+template <class Backoff = NoBackoff, class T>
+T fetch_min(std::atomic<T> &location, detail::non_deduced_t<T> value,
+            std::memory_order order = std::memory_order_seq_cst) {
+  return fetch_update_if<Backoff>(
+      location, [=](T current) { return value < current; },
+      [=](T) { return value; }, order);
+}
+
+// add for integral and floating point types, uses the native fetch_add if
+// available (floating point fetch_add requires C++20 library support)
+template <class Backoff = NoBackoff, class T>
+T fetch_add(std::atomic<T> &location, detail::non_deduced_t<T> value,
+            std::memory_order order = std::memory_order_seq_cst) {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>);
+#if defined(__cpp_lib_atomic_float)
+  constexpr bool native = true;
+#else
+  constexpr bool native = std::is_integral_v<T>;
+#endif
+  if constexpr (native) {
+    return location.fetch_add(value, order);
+  } else {
+    return fetch_update<Backoff>(
+        location, [=](T current) { return current + value; }, order);
+  }
+}
+
+// add for integral types that clamps to the range of T instead of overflowing
+template <class Backoff = NoBackoff, class T>
+T fetch_saturating_add(std::atomic<T> &location,
+                       detail::non_deduced_t<T> value,
+                       std::memory_order order = std::memory_order_seq_cst) {
+  static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>);
+  using limits = std::numeric_limits<T>;
+  if (value == 0) {
+    return location.load(std::memory_order_relaxed);
+  }
+  // saturated values do not change anymore
+  if (value > 0) {
+    return fetch_update_if<Backoff>(
+        location, [](T current) { return current != limits::max(); },
+        [=](T current) {
+          return current > limits::max() - value ? limits::max()
+                                                 : T(current + value);
+        },
+        order);
+  }
+  return fetch_update_if<Backoff>(
+      location, [](T current) { return current != limits::min(); },
+      [=](T current) {
+        return current < limits::min() - value ? limits::min()
+                                               : T(current + value);
+      },
+      order);
+}
+
 } // namespace lockfree
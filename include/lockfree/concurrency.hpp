@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "lockfree/exchange_buffer.hpp"
+#include "lockfree/index_pool.hpp"
+#include "lockfree/spsc_exchange_buffer.hpp"
+#include "lockfree/spsc_take_buffer.hpp"
+#include "lockfree/take_buffer.hpp"
+
+namespace lockfree {
+
+// Compile-time concurrency policy of the buffers, e.g.
+//
+//   ExchangeBufferFor<T, Producers::Single, Consumers::Single> buffer;
+//
+// selects the triple buffer for a single producer and a single consumer and
+// the general (multi-producer multi-consumer) buffer otherwise.
+// The capacity C and the IndexPoolType are only used by the general buffers.
+
+enum class Producers { Single, Multiple };
+enum class Consumers { Single, Multiple };
+
+template <class T, Producers P = Producers::Multiple,
+          Consumers Q = Consumers::Multiple, uint32_t C = 8,
+          class IndexPoolType = IndexPool<C>>
+using ExchangeBufferFor =
+    std::conditional_t<P == Producers::Single && Q == Consumers::Single,
+                       SpscExchangeBuffer<T>,
+                       ExchangeBuffer<T, C, IndexPoolType>>;
+
+template <class T, Producers P = Producers::Multiple,
+          Consumers Q = Consumers::Multiple, uint32_t C = 8,
+          class IndexPoolType = IndexPool<C>>
+using TakeBufferFor =
+    std::conditional_t<P == Producers::Single && Q == Consumers::Single,
+                       SpscTakeBuffer<T>, TakeBuffer<T, C, IndexPoolType>>;
+
+} // namespace lockfree
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "lockfree/backoff.hpp"
+#include "lockfree/sync_counter.hpp"
+
+// 16 byte (double width) CAS: cmpxchg16b on x86-64 (requires -mcx16, cf.
+// LOCKFREE_DWCAS in CMakeLists.txt) and ldxp/stxp or casp on AArch64
+// note: std::atomic of 16 byte types is not lock-free with GCC (it calls
+//       libatomic), hence we use the __sync builtins which are inlined
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define LOCKFREE_HAS_DWCAS 1
+#else
+#define LOCKFREE_HAS_DWCAS 0
+#endif
+
+namespace lockfree {
+
+#if LOCKFREE_HAS_DWCAS
+
+// SyncCounter updating both counters with a single 16 byte CAS, i.e. the
+// counters are always equal and no helping is required
+// (all operations are seq_cst, the __sync builtins are full barriers)
+class DwcasSyncCounter {
+public:
+  template <class Backoff = NoBackoff> void increment() {
+    Backoff backoff;
+    auto old = load();
+    while (true) {
+      auto prev = __sync_val_compare_and_swap(
+          &m_counts, old, pack(count1(old) + 1, count2(old) + 1));
+      if (prev == old) {
+        return;
+      }
+      old = prev;
+      backoff.backoff();
+    }
+  }
+
+  uint64_t sync() { return count1(load()); }
+
+  std::pair<uint64_t, uint64_t> get_if_equal() {
+    auto counts = load();
+    return {count1(counts), count2(counts)};
+  }
+
+private:
+  using counts_t = unsigned __int128;
+
+  // count1 in the low and count2 in the high half (adjacent words)
+  alignas(16) counts_t m_counts{0};
+
+  static counts_t pack(uint64_t count1, uint64_t count2) {
+    return counts_t(count2) << 64 | count1;
+  }
+  static uint64_t count1(counts_t counts) { return uint64_t(counts); }
+  static uint64_t count2(counts_t counts) { return uint64_t(counts >> 64); }
+
+  // atomic 16 byte load by a CAS that writes the value it replaces (there is
+  // no plain 16 byte atomic load)
+  counts_t load() { return __sync_val_compare_and_swap(&m_counts, 0, 0); }
+};
+
+// the fastest SyncCounter of the platform (selected at compile time)
+using NativeSyncCounter = DwcasSyncCounter;
+
+#else
+
+// fallback to the helping protocol
+using NativeSyncCounter = SyncCounter;
+
+#endif
+
+} // namespace lockfree
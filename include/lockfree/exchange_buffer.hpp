@@ -5,59 +5,181 @@
 #include <cstring>
 #include <optional>
 #include <type_traits>
+#include <utility>
 
+#include "lockfree/atomic.hpp"
+#include "lockfree/backoff.hpp"
+#include "lockfree/futex.hpp"
 #include "lockfree/index_pool.hpp"
+#include "lockfree/loan.hpp"
+#include "lockfree/read_handle.hpp"
+#include "lockfree/sanitizer.hpp"
 #include "lockfree/storage.hpp"
 
 namespace lockfree {
 
-template <class T, uint32_t C = 8> class ExchangeBuffer {
+// IndexPoolType can be any pool with the IndexPool interface and capacity C,
+// e.g. FreeListIndexPool<C> for constant time index allocation
+// Backoff is the policy applied after a failed attempt in the retry loops of
+// write, take and read (cf. backoff.hpp)
+//
+// T may be any copyable type. Trivially copyable values are read with a
+// copy validated by loads only (cf. read), other values are read from a
+// pinned slot, i.e. a slot is destroyed and reused only after the last
+// reader copied it (reference counting, like the read handles).
+// Move-only T (e.g. std::unique_ptr) can be written (write(T&&), emplace,
+// loan) and taken (take, take_handle) but not read, since take has to copy
+// a value pinned by a reader.
+//
+// take and read return a std::optional (the value is stored in place, no
+// dynamic memory) or assign the value to an existing object (take(out),
+// read(out)), e.g. to reuse its memory. Both are lock-free if copying
+// (moving) T is.
+template <class T, uint32_t C = 8, class IndexPoolType = IndexPool<C>,
+          class Backoff = NoBackoff>
+class ExchangeBuffer {
 private:
   using storage_t = Storage<T, C>;
-  using indexpool_t = lockfree::IndexPool<C>;
+  using indexpool_t = IndexPoolType;
   using index_t = typename indexpool_t::index_t;
 
   static constexpr index_t NO_DATA = C;
 
+  static_assert(indexpool_t::CAPACITY == C);
+
   struct tagged_index {
     tagged_index(index_t index) : index(index) {}
     tagged_index(index_t index, uint32_t counter)
         : index(index), counter(counter) {}
     index_t index;
     uint32_t counter{0};
+
+    bool operator==(const tagged_index &other) const {
+      return index == other.index && counter == other.counter;
+    }
   };
 
-  static_assert(std::atomic<tagged_index>::is_always_lock_free);
-  static_assert(std::is_trivially_copyable<T>::value);
+  static_assert(atomic<tagged_index>::is_always_lock_free);
+
+  static constexpr bool COPYABLE = std::is_copy_constructible<T>::value;
 
-  std::atomic<tagged_index> m_index{NO_DATA};
+  // a concurrently overwritten slot can be copied without harm and the copy
+  // be discarded afterwards
+  static constexpr bool VALIDATED_READ =
+      COPYABLE && std::is_trivially_copyable<T>::value;
+
+  // Reference counts of the slots to pin slots for read handles.
+  // A published slot holds one reference of the buffer and one per handle.
+  // The slot is freed by whoever drops the last reference.
+  //
+  // Readers increment the count before they can validate that the slot is
+  // still published. Such a speculative increment may hit a slot that is
+  // already freed (and is undone afterwards). To not free a slot twice, the
+  // count of free slots is marked with the FREED bit and only the one
+  // setting this bit (by CAS from 0) frees the slot.
+  static constexpr uint32_t FREED = 1U << 31;
+
+  atomic<tagged_index> m_index{NO_DATA};
+  // number of consumers blocked in take_wait or read_wait and the word they
+  // wait on (changed by publications while there are waiters)
+  atomic<uint32_t> m_waiters{0};
+  atomic<uint32_t> m_epoch{0};
+  atomic<uint32_t> m_refs[C];
+  // waiters may be parked in other processes (shared futex)
+  bool m_processShared{false};
   indexpool_t m_indices;
   storage_t m_storage;
 
 public:
-  bool write(const T &value) {
-    auto maybeIndex = m_indices.get();
-    if (!maybeIndex) {
+  using loan_t = Loan<T, ExchangeBuffer>;
+  using handle_t = ReadHandle<T, ExchangeBuffer>;
+
+  ExchangeBuffer() {
+    for (auto &refs : m_refs) {
+      refs.store(FREED, std::memory_order_relaxed);
+    }
+  }
+
+  // construct the buffer in memory shared between processes, the buffer
+  // holds no pointers and can be mapped at different addresses
+  // (cf. shm_exchange_buffer.hpp)
+  explicit ExchangeBuffer(process_shared_t) : ExchangeBuffer() {
+    m_processShared = true;
+  }
+
+  // destroys the published value (there must be no loans or handles left)
+  ~ExchangeBuffer() {
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      auto index = unpublish();
+      if (index != NO_DATA) {
+        release(index);
+      }
+    }
+  }
+
+  bool write(const T &value) { return emplace(value); }
+
+  bool write(T &&value) { return emplace(std::move(value)); }
+
+  // construct the value in place and publish it (like write)
+  template <class... Args> bool emplace(Args &&...args) {
+    auto slot = loan();
+    if (!slot) {
       return false; // no index
     }
-    tagged_index newIndex{maybeIndex.value()};
-    m_storage.store_at(value, newIndex.index);
+    slot.emplace(std::forward<Args>(args)...);
+    return publish(std::move(slot));
+  }
+
+  // obtain an uninitialized slot to construct a value in place,
+  // the loan is invalid if there is no free slot
+  loan_t loan() {
+    auto maybeIndex = get_index();
+    if (!maybeIndex) {
+      return loan_t(); // no index
+    }
+    auto index = maybeIndex.value();
+    return loan_t(this, index, m_storage.ptr(index));
+  }
+
+  // publish the value constructed in a loaned slot (like write)
+  // fails if the loan holds no value (or belongs to another buffer)
+  bool publish(loan_t &&loan) {
+    if (!loan.has_value() || loan.m_owner != this) {
+      return false;
+    }
+    // the buffer takes over ownership of the slot
+    tagged_index newIndex{loan.m_index};
+    loan.m_owner = nullptr;
+    // before the reference count is set, a reclaimed slot must be free
+    disown(newIndex.index);
+    acquire(newIndex.index);
 
-    tagged_index old = m_index.load();
+    Backoff backoff;
+    tagged_index old = m_index.load(std::memory_order_relaxed);
     do {
       newIndex.counter = old.counter + 1;
-      if (m_index.compare_exchange_strong(old, newIndex)) {
+      // release: publish the value (and its reference count)
+      // acquire: the value we replace is completely written before we may
+      // free it
+      // seq_cst: cf. notify (no extra cost compared to acq_rel on x86 and
+      //          ARMv8)
+      if (m_index.compare_exchange_weak(old, newIndex,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        notify();
         if (old.index != NO_DATA) {
-          free(old.index);
+          release(old.index);
         }
         return true;
       }
+      backoff.backoff();
     } while (true);
     return true;
   }
 
   bool try_write(const T &value) {
-    auto maybeIndex = m_indices.get();
+    auto maybeIndex = get_index();
     if (!maybeIndex) {
       return false; // no index
     }
@@ -65,61 +187,349 @@ public:
     tagged_index newIndex{maybeIndex.value()};
 
     m_storage.store_at(value, newIndex.index);
+    disown(newIndex.index);
+    acquire(newIndex.index);
 
-    tagged_index old = m_index.load();
+    Backoff backoff;
+    tagged_index old = m_index.load(std::memory_order_relaxed);
     while (old.index == NO_DATA) {
       newIndex.counter = old.counter + 1;
-      if (m_index.compare_exchange_strong(old, newIndex)) {
+      // release: publish the value, seq_cst: cf. notify
+      if (m_index.compare_exchange_weak(old, newIndex,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        notify();
         return true;
       }
+      backoff.backoff();
     }
 
-    free(newIndex.index);
+    release(newIndex.index);
     return false;
   };
 
   std::optional<T> take() {
+    std::optional<T> ret;
+    take_with([&](auto &&value) {
+      ret.emplace(std::forward<decltype(value)>(value));
+    });
+    return ret;
+  }
+
+  // take the value into out (assigned, i.e. out can be reused and no
+  // temporary is constructed), returns false and leaves out unchanged if
+  // there is no value
+  bool take(T &out) {
+    return take_with(
+        [&](auto &&value) { out = std::forward<decltype(value)>(value); });
+  }
+
+  // take the value, blocks for at most timeout while the buffer is empty
+  // (instead of polling with take)
+  template <class Rep, class Period>
+  std::optional<T>
+  take_wait(const std::chrono::duration<Rep, Period> &timeout) {
+    return wait_for([this] { return take(); }, timeout);
+  }
+
+  template <class Rep, class Period>
+  bool take_wait(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+    return wait_for([&] { return take(out); }, timeout);
+  }
+
+  // take the value without copying it out of the buffer,
+  // the handle is empty if there is no value
+  handle_t take_handle() {
+    auto index = unpublish();
+    if (index == NO_DATA) {
+      return handle_t();
+    }
+    // the handle owns the reference of the buffer now
+    return handle_t(this, index, m_storage.ptr(index));
+  }
+
+  // read the value without copying it, the slot cannot be reused until the
+  // handle is released (hence the handle should be released soon)
+  // the handle is empty if there is no value
+  handle_t read_handle() {
+    static_assert(COPYABLE, "a pinned value is copied by take");
+    Backoff backoff;
+    auto old = m_index.load(std::memory_order_acquire);
+    while (old.index != NO_DATA) {
+      // speculatively pin the slot, if it is still published afterwards
+      // the buffer still held its reference while we incremented the count
+      // seq_cst (store-load, like a hazard pointer): the increment and the
+      // validating load pair with the unpublishing CAS and the load of the
+      // count in take_with, either our load sees the unpublish (and we
+      // retry) or take sees our pin (and copies instead of moving)
+      m_refs[old.index].fetch_add(1, std::memory_order_seq_cst);
+      auto current = m_index.load(std::memory_order_seq_cst);
+      if (current == old) {
+        return handle_t(this, old.index, m_storage.ptr(old.index));
+      }
+      // undo and retry, the slot may be freed by us if it was unpublished
+      // concurrently
+      release(old.index);
+      old = current;
+      backoff.backoff();
+    }
+
+    return handle_t();
+  }
+
+  std::optional<T> read() {
+    std::optional<T> ret;
+    if (read_with([&](const T &value) { ret.emplace(value); })) {
+      return ret;
+    }
+    // a copy that failed validation may be left over
+    return std::nullopt;
+  }
+
+  // read the value into out (copy assigned, i.e. out can be reused),
+  // returns false and leaves out unchanged if there is no value
+  bool read(T &out) {
+    if constexpr (VALIDATED_READ) {
+      // a copy may be torn until it is validated, i.e. it is made locally
+      // (trivially copyable, no temporary resources) and assigned afterwards
+      auto value = read();
+      if (!value) {
+        return false;
+      }
+      out = *value;
+      return true;
+    }
+    return read_with([&](const T &value) { out = value; });
+  }
+
+  // read the value, blocks for at most timeout while the buffer is empty
+  template <class Rep, class Period>
+  std::optional<T>
+  read_wait(const std::chrono::duration<Rep, Period> &timeout) {
+    return wait_for([this] { return read(); }, timeout);
+  }
+
+  template <class Rep, class Period>
+  bool read_wait(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+    return wait_for([&] { return read(out); }, timeout);
+  }
+
+  bool empty() {
+    return m_index.load(std::memory_order_relaxed).index == NO_DATA;
+  }
+
+  // reclaim the slots taken by processes that died before they published or
+  // returned them (e.g. loans), returns the number of reclaimed slots
+  //
+  // requires a buffer shared between processes and an index pool with owners
+  // (e.g. IndexPool), otherwise slots are taken anonymously and never
+  // reclaimed
+  // note: a slot that is unpublished (take) or pinned (read handle) by a
+  //       dying process is not reclaimed
+  uint32_t scavenge() {
+#ifdef LOCKFREE_HAS_PROCESS_OWNER
+    if constexpr (has_owners<indexpool_t>::value) {
+      // the values are trivially copyable (cf. ShmExchangeBuffer), i.e. need
+      // no destruction
+      return m_indices.scavenge(
+          [](Owner owner) { return process_alive(owner); });
+    }
+#endif
+    return 0;
+  }
+
+private:
+  friend loan_t;
+  friend handle_t;
+
+  // pass the taken value to consume (as rvalue if no handle reads it
+  // anymore), returns false if there is no value
+  template <class Consume> bool take_with(Consume &&consume) {
+    auto index = unpublish();
+    if (index == NO_DATA) {
+      return false;
+    }
+
+    // we own the reference of the buffer now, but there may still be handles
+    // reading the value (new handles cannot pin the slot anymore)
+    // seq_cst: a reader that validated against the unpublished index pinned
+    // the slot before our CAS, i.e. we see its pin (cf. read_handle)
+    // acquire: released handles are done reading before we move the value
+    // (move-only values cannot be read, i.e. are never pinned)
+    if constexpr (COPYABLE) {
+      if (m_refs[index].load(std::memory_order_seq_cst) != 1) {
+        consume(static_cast<const T &>(m_storage[index]));
+        release(index);
+        return true;
+      }
+    }
+    consume(std::move(m_storage[index]));
+    release(index);
+    return true;
+  }
+
+  // pass the current value to copy, which may be called several times
+  // (only the last copy is valid), returns false if there is no value
+  template <class Copy> bool read_with(Copy &&copy) {
+    static_assert(COPYABLE, "a pinned value is copied by take");
+    if constexpr (!VALIDATED_READ) {
+      // copying a value that is destroyed concurrently is undefined,
+      // the slot is pinned until we copied it
+      auto handle = read_handle();
+      if (!handle) {
+        return false;
+      }
+      copy(static_cast<const T &>(*handle));
+      return true;
+    }
+
+    Backoff backoff;
+    auto old = m_index.load(std::memory_order_acquire);
+    while (old.index != NO_DATA) {
+      // the slot may be freed and reused concurrently, i.e. the copy may be
+      // corrupted (this is why we only do this for trivially copyable T)
+      LOCKFREE_IGNORE_READS_BEGIN();
+      copy(static_cast<const T &>(m_storage[old.index]));
+      LOCKFREE_IGNORE_READS_END();
+
+      // validate the copy with a load only (like a seqlock), if index and
+      // counter did not change the slot was not freed while we copied it
+      // (any write or take changes the counter)
+      // readers hence do not write to the shared index and do not interfere
+      // with each other or the writers
+      // the fence ensures the copy happens before the validating load
+      thread_fence(std::memory_order_acquire);
+      auto current = m_index.load(std::memory_order_acquire);
+      if (current == old) {
+        return true;
+      }
+      // either the index or the counter changed (due to a concurrent write or
+      // take), retry with the current index
+      old = current;
+      backoff.backoff();
+    }
+
+    return false;
+  }
+
+  // remove the value from the buffer and return its index (or NO_DATA),
+  // the caller owns the reference of the buffer afterwards
+  index_t unpublish() {
     // we basically write no data to the buffer
     // and return its content (if any)
     tagged_index newIndex(NO_DATA);
-    auto old = m_index.load();
+    Backoff backoff;
+    auto old = m_index.load(std::memory_order_relaxed);
 
     while (old.index != NO_DATA) {
       newIndex.counter = old.counter + 1;
-      if (m_index.compare_exchange_strong(old, newIndex)) {
+      // acquire: we see the value written before it was published
+      // seq_cst: ordered before the load of the count in take_with
+      // (cf. read_handle)
+      if (m_index.compare_exchange_weak(old, newIndex,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
         // we know there was data due to the while loop condition
-        std::optional<T> ret(std::move(m_storage[old.index]));
-        free(old.index);
-        return ret;
+        return old.index;
       }
       // either retry or exit loop if there is NO_DATA
+      backoff.backoff();
     };
 
-    return std::nullopt;
+    return NO_DATA;
   }
 
-  std::optional<T> read() {
-    auto old = m_index.load();
-    while (old.index != NO_DATA) {
-      auto ret = std::optional<T>(m_storage[old.index]);
+  // retry op until it returns a value (or true), park on m_epoch in between
+  template <class Op, class Rep, class Period>
+  auto wait_for(Op &&op, const std::chrono::duration<Rep, Period> &timeout)
+      -> decltype(op()) {
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now() + timeout;
+    while (true) {
+      if (auto value = op()) {
+        return value;
+      }
+      auto remaining = deadline - clock::now();
+      if (remaining <= clock::duration::zero()) {
+        return {}; // empty optional or false
+      }
 
-      if (m_index.compare_exchange_strong(old, old)) {
-        return ret;
+      m_waiters.fetch_add(1, std::memory_order_seq_cst);
+      auto epoch = m_epoch.load(std::memory_order_acquire);
+      // recheck after registering, a producer publishing afterwards sees us
+      // (cf. notify) and changes the epoch before it wakes us
+      if (m_index.load(std::memory_order_seq_cst).index == NO_DATA) {
+        futex_wait(m_epoch, epoch, remaining, m_processShared);
       }
-      // if this failed either the index or the counter changed (due to a
-      // concurrent write)
+      m_waiters.fetch_sub(1, std::memory_order_relaxed);
     }
+  }
 
-    return std::nullopt;
+  // wake blocked consumers after a publication,
+  // producers only pay for a load if there are no waiters
+  void notify() {
+    // the publication and the registration of waiters are seq_cst, i.e.
+    // either we see the waiter or the waiter sees our value when it rechecks
+    // the buffer after its registration
+    if (m_waiters.load(std::memory_order_seq_cst) == 0) {
+      return;
+    }
+    m_epoch.fetch_add(1, std::memory_order_release);
+    futex_wake_all(m_epoch, m_processShared);
   }
 
-  bool empty() { return m_index.load().index == NO_DATA; }
+  // set the reference of the buffer before a slot is published
+  // (preserving speculative increments of readers)
+  // (ordered by the release of the publishing CAS)
+  void acquire(index_t index) {
+    m_refs[index].fetch_sub(FREED - 1, std::memory_order_relaxed);
+  }
+
+  // drop a reference and free the slot if it was the last one
+  void release(index_t index) {
+    auto &refs = m_refs[index];
+    // release: we are done with the slot before it may be freed
+    // acquire: all other references are done when we free it
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // a speculative reader may increment (and decrement) concurrently,
+      // only the one who marks the count as FREED frees the slot
+      uint32_t expected = 0;
+      if (refs.compare_exchange_strong(expected, FREED,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        free(index);
+      }
+    }
+  }
 
-private:
   void free(index_t index) {
     m_storage.free(index);
     m_indices.free(index);
   }
+
+  // return an unpublished loaned slot (the value is already destroyed)
+  void release(loan_t &loan) { m_indices.free(loan.m_index); }
+
+  // the slots taken by a process shared buffer are owned by the process
+  // until they are published (cf. scavenge)
+  std::optional<index_t> get_index() {
+#ifdef LOCKFREE_HAS_PROCESS_OWNER
+    if constexpr (has_owners<indexpool_t>::value) {
+      if (m_processShared) {
+        return m_indices.get(process_owner());
+      }
+    }
+#endif
+    return m_indices.get();
+  }
+
+  void disown(index_t index) {
+    if constexpr (has_owners<indexpool_t>::value) {
+      if (m_processShared) {
+        m_indices.disown(index);
+      }
+    }
+  }
 }; // namespace lockfree
 
 } // namespace lockfree
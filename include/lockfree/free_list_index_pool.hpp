@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+
+#include "lockfree/layout.hpp"
+
+namespace lockfree {
+
+// Constant time alternative to IndexPool.
+// The free indices form a linked list (Treiber stack) where the links are
+// stored in an array of next indices. The head of the list is tagged with a
+// counter to avoid the ABA problem (similar to the ExchangeBuffer).
+template <uint32_t Size, class Layout = PackedLayout> class FreeListIndexPool {
+public:
+  using index_t = uint32_t;
+
+  static constexpr uint32_t CAPACITY = Size;
+
+private:
+  static constexpr index_t END = Size;
+
+  struct tagged_index {
+    index_t index;
+    uint32_t counter;
+  };
+
+  static_assert(std::atomic<tagged_index>::is_always_lock_free);
+
+public:
+  FreeListIndexPool() {
+    // initially all indices are free and linked in ascending order
+    for (index_t index = 0; index < Size; ++index) {
+      m_next[index].value.store(index + 1, std::memory_order_relaxed);
+    }
+    m_head.store(tagged_index{0, 0}, std::memory_order_relaxed);
+  }
+
+  std::optional<index_t> get() {
+    // acquire: we see the next index stored by the thread which pushed head
+    // (and the previous owner is done with the index)
+    auto head = m_head.load(std::memory_order_acquire);
+    while (head.index != END) {
+      // the next index may be outdated if head is outdated, but then the
+      // CAS will fail since the counter has changed
+      tagged_index newHead{
+          m_next[head.index].value.load(std::memory_order_relaxed),
+          head.counter + 1};
+      if (m_head.compare_exchange_weak(head, newHead,
+                                       std::memory_order_acquire,
+                                       std::memory_order_acquire)) {
+        return head.index;
+      }
+      // head was updated, retry
+    }
+
+    return std::nullopt;
+  }
+
+  void free(index_t index) {
+    auto head = m_head.load(std::memory_order_relaxed);
+    tagged_index newHead{index, 0};
+    do {
+      // we own index exclusively until the CAS succeeds
+      m_next[index].value.store(head.index, std::memory_order_relaxed);
+      newHead.counter = head.counter + 1;
+      // release: publish the next index (and our use of the index)
+    } while (!m_head.compare_exchange_weak(head, newHead,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  }
+
+private:
+  std::atomic<tagged_index> m_head;
+  typename Layout::template slot<std::atomic<index_t>> m_next[Size];
+};
+
+} // namespace lockfree
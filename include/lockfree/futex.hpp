@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "lockfree/atomic.hpp"
+
+#if defined(__linux__) && !defined(LOCKFREE_MODEL_CHECK)
+#define LOCKFREE_HAS_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace lockfree {
+
+// tag to construct a structure in memory shared between processes
+struct process_shared_t {};
+inline constexpr process_shared_t process_shared{};
+
+// Minimal futex wrapper to park threads on a 32 bit atomic word
+// (C++17 has no std::atomic::wait).
+// Without futex support (or in the model checker) we fall back to polling
+// with yield.
+//
+// Words in memory shared between processes (cf. shm_exchange_buffer.hpp) need
+// shared futexes, private futexes (default) are cheaper since the kernel can
+// identify them by address alone.
+//
+// note: wait may return spuriously, i.e. callers must recheck their condition
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t));
+
+// block while word == expected, at most for timeout
+template <class Rep, class Period>
+void futex_wait(atomic<uint32_t> &word, uint32_t expected,
+                const std::chrono::duration<Rep, Period> &timeout,
+                bool processShared = false) {
+  using namespace std::chrono;
+  auto ns = duration_cast<nanoseconds>(timeout).count();
+  if (ns <= 0) {
+    return;
+  }
+#ifdef LOCKFREE_HAS_FUTEX
+  timespec ts;
+  ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+  ts.tv_nsec = static_cast<long>(ns % 1000000000);
+  // returns immediately if the word does not contain expected anymore
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+          processShared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, &ts,
+          nullptr, 0);
+#else
+  (void)processShared;
+  auto deadline = steady_clock::now() + nanoseconds(ns);
+  while (word.load(std::memory_order_acquire) == expected &&
+         steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+#endif
+}
+
+// wake all threads waiting on word (word must be changed before)
+inline void futex_wake_all(atomic<uint32_t> &word,
+                           bool processShared = false) {
+#ifdef LOCKFREE_HAS_FUTEX
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+          processShared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr,
+          nullptr, 0);
+#else
+  (void)word;
+  (void)processShared;
+#endif
+}
+
+} // namespace lockfree
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <type_traits>
+
+#include "lockfree/index_pool.hpp"
+#include "lockfree/sanitizer.hpp"
+#include "lockfree/storage.hpp"
+
+namespace lockfree {
+
+// Buffer keeping the last Depth values written (ring of tagged indices).
+// Writers never wait for readers and readers never block writers, i.e. slow
+// readers may miss values that were overwritten in the meantime.
+//
+// C is the number of storage slots and has to be larger than Depth by at
+// least the number of concurrent writers (each writer needs a slot before
+// it can publish its value).
+template <class T, uint32_t Depth, uint32_t C = Depth + 8,
+          class IndexPoolType = IndexPool<C>>
+class HistoryBuffer {
+private:
+  using storage_t = Storage<T, C>;
+  using indexpool_t = IndexPoolType;
+  using index_t = typename indexpool_t::index_t;
+
+  static constexpr index_t NO_DATA = C;
+
+  static_assert(Depth > 0);
+  static_assert(C > Depth);
+  static_assert(indexpool_t::CAPACITY == C);
+
+  // the counter is the (truncated) sequence number of the write whose value
+  // is stored at index, it protects against ABA like in ExchangeBuffer and
+  // allows to detect whether a ring entry was overwritten by a newer write
+  struct tagged_index {
+    index_t index;
+    uint32_t counter;
+
+    bool operator==(const tagged_index &other) const {
+      return index == other.index && counter == other.counter;
+    }
+  };
+
+  static_assert(std::atomic<tagged_index>::is_always_lock_free);
+  static_assert(std::is_trivially_copyable<T>::value);
+
+  // number of writes so far (sequence number of the last write),
+  // the write with sequence number s is stored at m_ring[s % Depth]
+  std::atomic<uint64_t> m_sequence{0};
+  std::atomic<tagged_index> m_ring[Depth];
+  indexpool_t m_indices;
+  storage_t m_storage;
+
+public:
+  HistoryBuffer() {
+    for (auto &entry : m_ring) {
+      entry.store(tagged_index{NO_DATA, 0}, std::memory_order_relaxed);
+    }
+  }
+
+  // write new value, discarding the oldest value if there are Depth values
+  // returns false if there is no free slot
+  bool write(const T &value) {
+    auto maybeIndex = m_indices.get();
+    if (!maybeIndex) {
+      return false; // no index
+    }
+    auto index = maybeIndex.value();
+    m_storage.store_at(value, index);
+
+    // determine the position of our value in the history
+    // (relaxed since readers validate the entries by their counters)
+    auto sequence = m_sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+    tagged_index newEntry{index, static_cast<uint32_t>(sequence)};
+    auto &entry = m_ring[sequence % Depth];
+
+    auto old = entry.load(std::memory_order_relaxed);
+    while (!newer_or_equal(old, newEntry.counter)) {
+      // release: publish the value
+      // acquire: the value we replace is completely written before we free it
+      if (entry.compare_exchange_weak(old, newEntry, std::memory_order_acq_rel,
+                                      std::memory_order_relaxed)) {
+        if (old.index != NO_DATA) {
+          free(old.index);
+        }
+        return true;
+      }
+    }
+
+    // we were too slow, a newer write of another writer already occupies
+    // our entry, i.e. our value was overwritten (conceptually right after we
+    // wrote it)
+    free(index);
+    return true;
+  }
+
+  // read the latest value
+  std::optional<T> read_latest() {
+    std::optional<T> latest;
+    visit_last(1, [&](const T &value) { latest = value; });
+    return latest;
+  }
+
+  // read up to k of the latest values (newest first) into values
+  // returns the number of values read
+  //
+  // note: the values are in the order they were written, but they are not
+  //       read atomically, i.e. values overwritten while we read are skipped
+  //       and values written while we read are not included
+  uint32_t read_last(T *values, uint32_t k) {
+    return visit_last(k, [&](const T &value) { *values++ = value; });
+  }
+
+  // whether no value was published yet
+  // (m_sequence is incremented before the value is published, i.e. it could
+  // indicate a value that read_latest does not find yet)
+  bool empty() {
+    for (auto &entry : m_ring) {
+      if (entry.load(std::memory_order_acquire).index != NO_DATA) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  // calls consume for up to k of the latest values (newest first)
+  template <class Consumer>
+  uint32_t visit_last(uint32_t k, Consumer &&consume) {
+    auto last = m_sequence.load(std::memory_order_acquire);
+    uint32_t n = 0;
+    for (uint64_t sequence = last; sequence > 0 && n < k; --sequence) {
+      if (last - sequence >= Depth) {
+        break; // the values are overwritten
+      }
+
+      auto &entry = m_ring[sequence % Depth];
+      auto expected = static_cast<uint32_t>(sequence);
+      auto current = entry.load(std::memory_order_acquire);
+      if (current.index == NO_DATA || current.counter != expected) {
+        // the write is not completed yet (or was overwritten)
+        continue;
+      }
+
+      // the slot may be freed and reused concurrently, i.e. the copy may be
+      // corrupted, validate with loads only (cf. ExchangeBuffer::read)
+      LOCKFREE_IGNORE_READS_BEGIN();
+      std::optional<T> copy(m_storage[current.index]);
+      LOCKFREE_IGNORE_READS_END();
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (entry.load(std::memory_order_relaxed) == current) {
+        consume(*copy);
+        ++n;
+      }
+      // otherwise the value was overwritten while we copied it
+    }
+
+    return n;
+  }
+
+  // whether the entry contains a value at least as new as the write with the
+  // given (truncated) sequence number
+  static bool newer_or_equal(const tagged_index &entry, uint32_t counter) {
+    if (entry.index == NO_DATA) {
+      return false;
+    }
+    // sequence numbers of entries which can compete for the same entry
+    // differ by much less than 2^31, which allows comparison with wrap-around
+    return static_cast<int32_t>(entry.counter - counter) >= 0;
+  }
+
+  void free(index_t index) {
+    m_storage.free(index);
+    m_indices.free(index);
+  }
+};
+
+} // namespace lockfree
@@ -2,29 +2,57 @@
 
 #include <atomic>
 #include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "lockfree/atomic.hpp"
+#include "lockfree/layout.hpp"
+#include "lockfree/owner.hpp"
 
 namespace lockfree {
 
-template <uint32_t Size> class IndexPool {
+// Each used slot is tagged with the owner that took it (anonymous by
+// default). If an owner dies before it frees its indices (or hands them
+// over with disown, e.g. by publishing them in a buffer), scavenge reclaims
+// them.
+template <uint32_t Size, class Layout = PackedLayout> class IndexPool {
 private:
-  constexpr static uint8_t FREE = 0;
-  constexpr static uint8_t USED = 1;
+  // owner id (32 bits), owner epoch (31 bits), used bit
+  using word_t = uint64_t;
+  constexpr static word_t FREE = 0;
+  constexpr static word_t USED = 1;
+
+  static word_t used_by(Owner owner) {
+    return word_t(owner.id) << 32 |
+           word_t(owner.epoch & Owner::EPOCH_MASK) << 1 | USED;
+  }
+
+  static Owner owner_of(word_t word) {
+    return Owner{uint32_t(word >> 32), uint32_t(word) >> 1};
+  }
 
 public:
   using index_t = uint32_t;
 
+  static constexpr uint32_t CAPACITY = Size;
+
   IndexPool() {
     for (auto &slot : m_slots) {
-      slot.store(FREE);
+      slot.value.store(FREE, std::memory_order_relaxed);
     }
   }
 
-  std::optional<index_t> get() {
+  std::optional<index_t> get(Owner owner = Owner{}) {
+    auto used = used_by(owner);
     // single pass for simplicity
     for (index_t index = 0; index < Size; ++index) {
       auto expected = FREE;
-      auto &slot = m_slots[index];
-      if (slot.compare_exchange_strong(expected, USED)) {
+      auto &slot = m_slots[index].value;
+      // acquire: the previous owner is done with the index
+      // (strong since we do not retry a slot)
+      if (slot.compare_exchange_strong(expected, used,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
         return index;
       }
       // single pass for simplicity
@@ -34,17 +62,60 @@ public:
   }
 
   void free(index_t index) {
-    auto &slot = m_slots[index];
-    slot.store(FREE);
+    auto &slot = m_slots[index].value;
+    slot.store(FREE, std::memory_order_release);
+  }
+
+  // the index is not owned by the owner that took it anymore (but still
+  // used), i.e. it is not reclaimed if the owner dies
+  void disown(index_t index) {
+    m_slots[index].value.store(USED, std::memory_order_release);
+  }
+
+  // free the indices of owners that are not alive (alive(Owner) -> bool),
+  // returns the number of reclaimed indices
+  // lock-free and may run concurrently with all other operations (and other
+  // scavengers), an index is only freed if it is still used by the dead
+  // owner when it is reclaimed
+  template <class Alive> uint32_t scavenge(Alive &&alive) {
+    uint32_t reclaimed = 0;
+    for (index_t index = 0; index < Size; ++index) {
+      auto &slot = m_slots[index].value;
+      auto word = slot.load(std::memory_order_relaxed);
+      if (word == FREE || word == USED || alive(owner_of(word))) {
+        continue;
+      }
+      // release: the index is free for the next owner (cf. get)
+      if (slot.compare_exchange_strong(word, FREE, std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+        ++reclaimed;
+      }
+    }
+    return reclaimed;
+  }
+
+  // owner of a used index (anonymous if disowned)
+  Owner owner(index_t index) const {
+    return owner_of(m_slots[index].value.load(std::memory_order_relaxed));
   }
 
 private:
-  std::atomic<uint8_t> m_slots[Size];
+  static_assert(atomic<word_t>::is_always_lock_free);
+
+  typename Layout::template slot<atomic<word_t>> m_slots[Size];
 }; // namespace lockfree
+
+// index pools that tag their indices with owners (cf. IndexPool)
+template <class Pool, class = void> struct has_owners : std::false_type {};
+
+template <class Pool>
+struct has_owners<Pool, std::void_t<decltype(std::declval<Pool &>().disown(0))>>
+    : std::true_type {};
+
 } // namespace lockfree
 
 // note: in practice we would use a much faster and efficient allocator
 //       we can create a constant time lock-free allocator for T objects by
-//       using a lock-free index queue
+//       using a lock-free index queue or stack
 //
-//       note: iceoryx has such a queue
+//       note: iceoryx has such a queue, FreeListIndexPool uses a stack
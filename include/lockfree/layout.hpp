@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lockfree {
+
+// note: we do not use std::hardware_destructive_interference_size since its
+//       value may change with compiler version and tuning flags, which would
+//       silently change the layout of our data structures
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// Layout policies for arrays of slots accessed concurrently (IndexPool,
+// Storage etc.)
+
+// slots are stored back-to-back (smallest memory footprint)
+struct PackedLayout {
+  template <class T> struct slot { T value; };
+};
+
+// each slot starts at its own cache line to avoid false sharing between
+// threads accessing neighbouring slots (at the cost of memory)
+struct PaddedLayout {
+  template <class T> struct alignas(CACHE_LINE_SIZE) slot { T value; };
+};
+
+} // namespace lockfree
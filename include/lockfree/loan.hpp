@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace lockfree {
+
+// Handle to an uninitialized storage slot of a buffer (Owner).
+// The value is constructed in place in the slot and the loan is published
+// by the buffer afterwards, i.e. the value is never copied (zero-copy write).
+// If the loan is destroyed without being published the slot is returned to
+// the buffer.
+template <class T, class Owner> class Loan {
+public:
+  // invalid loan (the buffer had no free slot)
+  Loan() = default;
+
+  Loan(const Loan &) = delete;
+  Loan &operator=(const Loan &) = delete;
+
+  Loan(Loan &&other) noexcept
+      : m_owner(other.m_owner), m_index(other.m_index), m_ptr(other.m_ptr),
+        m_constructed(other.m_constructed) {
+    other.m_owner = nullptr;
+  }
+
+  Loan &operator=(Loan &&other) noexcept {
+    if (this != &other) {
+      release();
+      m_owner = other.m_owner;
+      m_index = other.m_index;
+      m_ptr = other.m_ptr;
+      m_constructed = other.m_constructed;
+      other.m_owner = nullptr;
+    }
+    return *this;
+  }
+
+  ~Loan() { release(); }
+
+  // true if we own a slot
+  explicit operator bool() const { return m_owner != nullptr; }
+
+  // true if a value was constructed in the slot
+  bool has_value() const { return m_owner != nullptr && m_constructed; }
+
+  // construct the value in place (replacing a previously constructed one)
+  // note: without arguments the value is default-initialized, i.e. trivial
+  //       types are not zeroed and can be filled without extra cost
+  template <class... Args> T &emplace(Args &&...args) {
+    destroy();
+    if constexpr (sizeof...(Args) == 0) {
+      new (m_ptr) T;
+    } else {
+      new (m_ptr) T(std::forward<Args>(args)...);
+    }
+    m_constructed = true;
+    return *m_ptr;
+  }
+
+  // access to the constructed value
+  T &operator*() { return *m_ptr; }
+  T *operator->() { return m_ptr; }
+
+private:
+  friend Owner;
+
+  Loan(Owner *owner, uint32_t index, T *ptr)
+      : m_owner(owner), m_index(index), m_ptr(ptr) {}
+
+  void destroy() {
+    if (m_constructed) {
+      m_ptr->~T();
+      m_constructed = false;
+    }
+  }
+
+  void release() {
+    if (m_owner) {
+      destroy();
+      m_owner->release(*this);
+      m_owner = nullptr;
+    }
+  }
+
+  Owner *m_owner{nullptr};
+  uint32_t m_index{0};
+  T *m_ptr{nullptr};
+  bool m_constructed{false};
+};
+
+} // namespace lockfree
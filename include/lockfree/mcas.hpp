@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <thread>
+
+#include "lockfree/index_pool.hpp"
+
+namespace lockfree {
+
+// Lock-free multi-word compare and swap (MCAS) after Harris, Fraser and Pratt,
+// "A Practical Multi-Word Compare-and-Swap Operation" (2002), i.e. the helping
+// scheme of the SyncCounter generalized to up to MaxWords words.
+//
+// An operation first installs a reference to its descriptor in all its words
+// (phase 1), decides whether it succeeded and replaces the references with the
+// desired (or expected) values afterwards (phase 2). A reference is installed
+// with RDCSS, a CAS that only succeeds while the operation is undecided.
+// Any thread encountering a reference (including readers) helps to complete
+// the operation first.
+//
+// The words are std::atomic<uint64_t> and must only be accessed by read and
+// cas of the same MCas object. The upper two bits of a word mark references,
+// i.e. values are limited to MAX_VALUE.
+//
+// Descriptors are reused instead of garbage collected: references contain a
+// sequence number of the descriptor that helpers validate after reading the
+// descriptor (like a seqlock). C is the number of descriptors of each kind and
+// should be at least the number of threads (a thread waits for a free
+// descriptor otherwise).
+template <uint32_t MaxWords = 8, uint32_t C = 64,
+          class IndexPoolType = IndexPool<C>>
+class MCas {
+public:
+  using word_t = std::atomic<uint64_t>;
+
+  struct Entry {
+    word_t *word;
+    uint64_t expected;
+    uint64_t desired;
+  };
+
+  static constexpr uint64_t MAX_VALUE = (uint64_t(1) << 62) - 1;
+
+  // value of the word (completes an operation in progress on the word first)
+  uint64_t read(word_t &word) {
+    while (true) {
+      auto value = word.load(std::memory_order_acquire);
+      if (value & RDCSS_REF) {
+        complete_rdcss(value);
+      } else if (value & MCAS_REF) {
+        help(value);
+      } else {
+        return value;
+      }
+    }
+  }
+
+  // set all words to their desired values if all words have their expected
+  // values (atomically), the words must be distinct
+  // fails (without changing any word) for more than MaxWords entries
+  bool cas(std::initializer_list<Entry> entries) {
+    return cas(entries.begin(), entries.end());
+  }
+
+  template <class It> bool cas(It first, It last) {
+    Operation op;
+    for (; first != last; ++first) {
+      if (op.size == MaxWords) {
+        return false;
+      }
+      assert(first->expected <= MAX_VALUE && first->desired <= MAX_VALUE);
+      op.entries[op.size++] = *first;
+    }
+    // a global order of the words ensures that helping terminates
+    // (insertion sort bounded by MaxWords, GCC 12 reports false positive
+    // -Warray-bounds warnings for std::sort of the entries)
+    const std::less<word_t *> less;
+    for (uint32_t i = 1; i < op.size && i < MaxWords; ++i) {
+      auto entry = op.entries[i];
+      auto j = i;
+      for (; j > 0 && less(entry.word, op.entries[j - 1].word); --j) {
+        op.entries[j] = op.entries[j - 1];
+      }
+      op.entries[j] = entry;
+    }
+    assert(std::adjacent_find(op.entries, op.entries + op.size,
+                              [](const Entry &a, const Entry &b) {
+                                return a.word == b.word;
+                              }) == op.entries + op.size);
+
+    auto index = get(m_mcasIndices);
+    auto &desc = m_mcas[index];
+    // the new sequence number invalidates references to the previous
+    // operation using the descriptor
+    auto seq = ((desc.status.load(std::memory_order_relaxed) >> 2) + 1) &
+               SEQ_MASK;
+    desc.status.store(seq << 2 | UNDECIDED, std::memory_order_relaxed);
+    // release: helpers reading the new fields see the new sequence number
+    std::atomic_thread_fence(std::memory_order_release);
+    desc.size.store(op.size, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < op.size; ++i) {
+      auto &entry = desc.entries[i];
+      entry.word.store(op.entries[i].word, std::memory_order_relaxed);
+      entry.expected.store(op.entries[i].expected, std::memory_order_relaxed);
+      entry.desired.store(op.entries[i].desired, std::memory_order_relaxed);
+    }
+
+    bool success = run(make_ref(MCAS_REF, index, seq), op);
+    // all references to the descriptor are replaced at this point
+    m_mcasIndices.free(index);
+    return success;
+  }
+
+private:
+  // a reference is a flag, the sequence number and the index of a descriptor
+  static constexpr uint64_t MCAS_REF = uint64_t(1) << 63;
+  static constexpr uint64_t RDCSS_REF = uint64_t(1) << 62;
+  static constexpr uint32_t INDEX_BITS = 16;
+  static constexpr uint64_t INDEX_MASK = (uint64_t(1) << INDEX_BITS) - 1;
+  static constexpr uint64_t SEQ_MASK = MAX_VALUE >> INDEX_BITS;
+
+  static_assert(C <= INDEX_MASK + 1);
+  static_assert(MaxWords > 0);
+
+  // status of an operation (together with the sequence number of the
+  // descriptor: seq << 2 | status)
+  static constexpr uint64_t UNDECIDED = 0;
+  static constexpr uint64_t SUCCEEDED = 1;
+  static constexpr uint64_t FAILED = 2;
+
+  struct Operation {
+    uint32_t size{0};
+    Entry entries[MaxWords];
+  };
+
+  // the fields are atomic since helpers may read them while they are reused
+  struct McasDescriptor {
+    std::atomic<uint64_t> status{0};
+    std::atomic<uint32_t> size{0};
+    struct {
+      std::atomic<word_t *> word{nullptr};
+      std::atomic<uint64_t> expected{0};
+      std::atomic<uint64_t> desired{0};
+    } entries[MaxWords];
+  };
+
+  // RDCSS: set word from expected to the reference of an operation (mcas) if
+  // the operation is undecided
+  struct RdcssDescriptor {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<word_t *> word{nullptr};
+    std::atomic<uint64_t> expected{0};
+    std::atomic<uint64_t> mcas{0};
+  };
+
+  McasDescriptor m_mcas[C];
+  RdcssDescriptor m_rdcss[C];
+  IndexPoolType m_mcasIndices;
+  IndexPoolType m_rdcssIndices;
+
+  static uint64_t make_ref(uint64_t flag, uint64_t index, uint64_t seq) {
+    return flag | (seq & SEQ_MASK) << INDEX_BITS | index;
+  }
+  static uint32_t index_of(uint64_t ref) { return ref & INDEX_MASK; }
+  static uint64_t seq_of(uint64_t ref) {
+    return (ref >> INDEX_BITS) & SEQ_MASK;
+  }
+
+  static uint32_t get(IndexPoolType &indices) {
+    while (true) {
+      if (auto index = indices.get()) {
+        return *index;
+      }
+      // more threads than descriptors
+      std::this_thread::yield();
+    }
+  }
+
+  // help to complete the operation of ref (if it is not complete yet)
+  void help(uint64_t ref) {
+    auto &desc = m_mcas[index_of(ref)];
+    Operation op;
+    op.size = std::min(desc.size.load(std::memory_order_relaxed), MaxWords);
+    for (uint32_t i = 0; i < op.size; ++i) {
+      auto &entry = desc.entries[i];
+      op.entries[i] = {entry.word.load(std::memory_order_relaxed),
+                       entry.expected.load(std::memory_order_relaxed),
+                       entry.desired.load(std::memory_order_relaxed)};
+    }
+    // validate the copy, if the descriptor was reused the operation of ref
+    // is complete
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((desc.status.load(std::memory_order_relaxed) >> 2) != seq_of(ref)) {
+      return;
+    }
+    run(ref, op);
+  }
+
+  // both phases of the operation, the result is only reliable for the owner
+  // (helpers may see a reused descriptor)
+  bool run(uint64_t ref, const Operation &op) {
+    auto &desc = m_mcas[index_of(ref)];
+    const auto seq = seq_of(ref);
+    auto status = desc.status.load(std::memory_order_acquire);
+
+    if (status == (seq << 2 | UNDECIDED)) {
+      auto decision = SUCCEEDED;
+      for (uint32_t i = 0; i < op.size && decision == SUCCEEDED;) {
+        auto &entry = op.entries[i];
+        auto value = rdcss(ref, entry);
+        if (value == entry.expected || value == ref) {
+          // installed (by us or a helper)
+          ++i;
+        } else if (value & MCAS_REF) {
+          // another operation is in the way, complete it and retry
+          help(value);
+        } else {
+          decision = FAILED;
+        }
+      }
+      // fails if a helper decided already (or the operation is complete)
+      desc.status.compare_exchange_strong(status, seq << 2 | decision,
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_relaxed);
+    }
+
+    status = desc.status.load(std::memory_order_acquire);
+    if ((status >> 2) != seq) {
+      // the descriptor was reused, i.e. the owner completed the operation
+      return false;
+    }
+    bool success = (status & 3) == SUCCEEDED;
+    for (uint32_t i = 0; i < op.size; ++i) {
+      auto &entry = op.entries[i];
+      auto expected = ref;
+      entry.word->compare_exchange_strong(
+          expected, success ? entry.desired : entry.expected,
+          std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+    return success;
+  }
+
+  // install the reference of the operation mcas in the word of entry if it
+  // has its expected value, returns the value the word had
+  uint64_t rdcss(uint64_t mcas, const Entry &entry) {
+    auto index = get(m_rdcssIndices);
+    auto &desc = m_rdcss[index];
+    auto seq = (desc.seq.load(std::memory_order_relaxed) + 1) & SEQ_MASK;
+    desc.seq.store(seq, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    desc.word.store(entry.word, std::memory_order_relaxed);
+    desc.expected.store(entry.expected, std::memory_order_relaxed);
+    desc.mcas.store(mcas, std::memory_order_relaxed);
+    auto ref = make_ref(RDCSS_REF, index, seq);
+
+    uint64_t value;
+    while (true) {
+      value = entry.expected;
+      if (entry.word->compare_exchange_strong(value, ref,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+        complete_rdcss(ref, entry.word, entry.expected, mcas);
+        value = entry.expected;
+        break;
+      }
+      if (!(value & RDCSS_REF)) {
+        break;
+      }
+      complete_rdcss(value);
+    }
+
+    // we completed our RDCSS, no word references the descriptor anymore
+    m_rdcssIndices.free(index);
+    return value;
+  }
+
+  void complete_rdcss(uint64_t ref) {
+    auto &desc = m_rdcss[index_of(ref)];
+    auto word = desc.word.load(std::memory_order_relaxed);
+    auto expected = desc.expected.load(std::memory_order_relaxed);
+    auto mcas = desc.mcas.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (desc.seq.load(std::memory_order_relaxed) != seq_of(ref)) {
+      // completed by its owner
+      return;
+    }
+    complete_rdcss(ref, word, expected, mcas);
+  }
+
+  void complete_rdcss(uint64_t ref, word_t *word, uint64_t expected,
+                      uint64_t mcas) {
+    auto &desc = m_mcas[index_of(mcas)];
+    bool undecided = desc.status.load(std::memory_order_acquire) ==
+                     (seq_of(mcas) << 2 | UNDECIDED);
+    word->compare_exchange_strong(ref, undecided ? mcas : expected,
+                                  std::memory_order_acq_rel,
+                                  std::memory_order_relaxed);
+  }
+};
+
+} // namespace lockfree
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lockfree::model {
+
+// Stateless model checker (in the style of CHESS or Relacy) for small tests of
+// the data structures.
+//
+// The data structures are compiled against model::atomic (cf.
+// lockfree/atomic.hpp, define LOCKFREE_MODEL_CHECK). The threads of a test run
+// one at a time and every atomic operation is a scheduling point at which the
+// scheduler chooses the thread to continue. Every execution of the test
+// follows a different sequence of choices (schedule), either random or
+// systematically enumerated (depth first, bounded by the number of
+// preemptions). A weak compare exchange may also fail spuriously.
+//
+// note: the executions are sequentially consistent interleavings, i.e. the
+//       reorderings allowed by weaker memory orders (store buffering,
+//       stale loads after relaxed or release/acquire operations) are not
+//       explored. The memory orders of the data structures are not validated.
+// note: only atomic operations are scheduling points, non-atomic accesses
+//       (such as copying a value into or out of a slot) execute as one step,
+//       i.e. a copy is never interleaved with a concurrent write (no torn
+//       copies). Use after free or reuse of a slot is detected (the copy
+//       happens at the wrong time), a data race within the copy is not.
+//
+// A test is a default constructible class with
+//   static constexpr uint32_t THREADS; // number of threads
+//   void run(uint32_t thread);         // executed by each thread
+//   void check();                      // invariants after all threads ended
+// that reports violations with require. Each execution uses a new test object.
+
+struct Options {
+  enum class Strategy { Random, Exhaustive };
+
+  Strategy strategy{Strategy::Random};
+  // number of executions (exhaustive: upper bound)
+  uint64_t executions{1000};
+  // random: seed of the schedules
+  uint64_t seed{0};
+  // exhaustive: maximum number of preemptions (and spurious failures) per
+  // execution
+  uint32_t preemptionBound{2};
+  // an execution exceeding this number of steps does not make progress
+  uint64_t maxSteps{100000};
+  bool spuriousFailures{true};
+};
+
+struct Result {
+  uint64_t executions{0};
+  // exhaustive: all schedules within the preemption bound were explored
+  bool complete{false};
+  // first violation (empty if none was found)
+  std::string failure;
+  // choices of the failing execution
+  std::vector<uint32_t> schedule;
+};
+
+class Scheduler {
+public:
+  static Scheduler &instance() {
+    static Scheduler scheduler;
+    return scheduler;
+  }
+
+  template <class Test> Result explore(const Options &options) {
+    Result result;
+    m_options = options;
+    m_random.seed(options.seed);
+    m_prefix.clear();
+    while (result.executions < options.executions) {
+      execute<Test>();
+      ++result.executions;
+      if (!m_failure.empty()) {
+        result.failure = m_failure;
+        for (auto &choice : m_trace) {
+          result.schedule.push_back(choice.chosen);
+        }
+        break;
+      }
+      if (options.strategy == Options::Strategy::Exhaustive &&
+          !next_schedule()) {
+        result.complete = true;
+        break;
+      }
+    }
+    return result;
+  }
+
+  // scheduling point of the calling thread (before each atomic operation)
+  void point() {
+    if (t_id < 0) {
+      return; // not a thread of the test (e.g. during setup)
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    int next;
+    if (m_draining) {
+      next = next_runnable(t_id + 1);
+    } else if (++m_steps > m_options.maxSteps) {
+      record_failure("no progress within " +
+                     std::to_string(m_options.maxSteps) + " steps");
+      m_draining = true;
+      next = next_runnable(t_id + 1);
+    } else {
+      // the current thread is the first option (continuing is no preemption)
+      std::vector<int> options{t_id};
+      for (int i = 0; i < int(m_finished.size()); ++i) {
+        if (i != t_id && !m_finished[i]) {
+          options.push_back(i);
+        }
+      }
+      uint32_t count = preemption_allowed() ? uint32_t(options.size()) : 1;
+      auto chosen = choose(count);
+      if (chosen != 0) {
+        ++m_preemptions;
+      }
+      next = options[chosen];
+    }
+    if (m_draining && ++m_drainSteps > 10 * m_options.maxSteps) {
+      std::fprintf(stderr, "model check: threads do not terminate\n");
+      std::abort();
+    }
+    switch_to(next, lock);
+  }
+
+  // whether a weak compare exchange of the calling thread fails spuriously
+  bool spurious_failure() {
+    if (t_id < 0 || !m_options.spuriousFailures) {
+      return false;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_draining || !preemption_allowed()) {
+      return false;
+    }
+    bool fail;
+    if (m_options.strategy == Options::Strategy::Random) {
+      // rarely, a retry is not interesting in most cases
+      fail = m_random() % 8 == 0;
+      m_trace.push_back({fail, 2});
+    } else {
+      fail = choose(2) == 1;
+    }
+    if (fail) {
+      ++m_preemptions;
+    }
+    return fail;
+  }
+
+  // report a violation (only the first one of an execution is kept)
+  void fail(const std::string &what) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    record_failure(what);
+  }
+
+private:
+  struct Choice {
+    uint32_t chosen;
+    uint32_t count;
+  };
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  Options m_options;
+  std::mt19937_64 m_random;
+
+  // state of the current execution
+  int m_current{-1};
+  std::vector<bool> m_finished;
+  uint64_t m_steps{0};
+  uint64_t m_drainSteps{0};
+  uint32_t m_preemptions{0};
+  // after a violation of maxSteps the threads are run round robin to end
+  bool m_draining{false};
+  std::string m_failure;
+  std::vector<Choice> m_trace;
+  // choices to replay at the start of the next execution
+  std::vector<Choice> m_prefix;
+
+  static inline thread_local int t_id = -1;
+
+  template <class Test> void execute() {
+    m_current = -1;
+    m_finished.assign(Test::THREADS, false);
+    m_steps = 0;
+    m_drainSteps = 0;
+    m_preemptions = 0;
+    m_draining = false;
+    m_failure.clear();
+    m_trace.clear();
+
+    auto test = std::make_unique<Test>();
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < Test::THREADS; ++i) {
+      threads.emplace_back([this, &test, i] {
+        t_id = int(i);
+        {
+          std::unique_lock<std::mutex> lock(m_mutex);
+          m_cv.wait(lock, [&] { return m_current == t_id; });
+        }
+        test->run(i);
+        finish();
+        t_id = -1;
+      });
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_current = int(choose(Test::THREADS));
+      m_cv.notify_all();
+      m_cv.wait(lock, [&] { return m_current == -1; });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    test->check();
+  }
+
+  void finish() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished[t_id] = true;
+    std::vector<int> options;
+    for (int i = 0; i < int(m_finished.size()); ++i) {
+      if (!m_finished[i]) {
+        options.push_back(i);
+      }
+    }
+    if (options.empty()) {
+      m_current = -1; // execution complete
+    } else if (m_draining) {
+      m_current = next_runnable(t_id + 1);
+    } else {
+      m_current = options[choose(uint32_t(options.size()))];
+    }
+    m_cv.notify_all();
+  }
+
+  void switch_to(int next, std::unique_lock<std::mutex> &lock) {
+    if (next == t_id) {
+      return;
+    }
+    m_current = next;
+    m_cv.notify_all();
+    m_cv.wait(lock, [&] { return m_current == t_id; });
+  }
+
+  int next_runnable(int from) const {
+    int n = int(m_finished.size());
+    for (int i = 0; i < n; ++i) {
+      int id = (from + i) % n;
+      if (!m_finished[id]) {
+        return id;
+      }
+    }
+    return -1;
+  }
+
+  bool preemption_allowed() const {
+    return m_options.strategy == Options::Strategy::Random ||
+           m_preemptions < m_options.preemptionBound;
+  }
+
+  // choose one of count options (replays the prefix first)
+  uint32_t choose(uint32_t count) {
+    if (count <= 1) {
+      return 0;
+    }
+    uint32_t chosen = 0;
+    if (m_trace.size() < m_prefix.size()) {
+      chosen = m_prefix[m_trace.size()].chosen;
+    } else if (m_options.strategy == Options::Strategy::Random) {
+      chosen = uint32_t(m_random() % count);
+    }
+    // exhaustive: new choices start with the first option and are advanced
+    // by next_schedule
+    m_trace.push_back({chosen, count});
+    return chosen;
+  }
+
+  // depth first: advance the last choice with options left
+  bool next_schedule() {
+    if (m_options.strategy == Options::Strategy::Random) {
+      m_prefix.clear();
+      return true;
+    }
+    while (!m_trace.empty()) {
+      auto &choice = m_trace.back();
+      if (choice.chosen + 1 < choice.count) {
+        ++choice.chosen;
+        m_prefix = m_trace;
+        return true;
+      }
+      m_trace.pop_back();
+    }
+    return false;
+  }
+
+  void record_failure(const std::string &what) {
+    if (m_failure.empty()) {
+      m_failure = what;
+    }
+  }
+};
+
+template <class Test> Result explore(const Options &options = {}) {
+  return Scheduler::instance().explore<Test>(options);
+}
+
+inline void require(bool condition, const char *what) {
+  if (!condition) {
+    Scheduler::instance().fail(what);
+  }
+}
+
+// std::atomic with a scheduling point before every operation
+template <class T> class atomic {
+public:
+  static constexpr bool is_always_lock_free =
+      std::atomic<T>::is_always_lock_free;
+
+  atomic() noexcept = default;
+  constexpr atomic(T value) noexcept : m_value(value) {}
+
+  atomic(const atomic &) = delete;
+  atomic &operator=(const atomic &) = delete;
+
+  T load(std::memory_order order = std::memory_order_seq_cst) const {
+    Scheduler::instance().point();
+    return m_value.load(order);
+  }
+
+  void store(T value, std::memory_order order = std::memory_order_seq_cst) {
+    Scheduler::instance().point();
+    m_value.store(value, order);
+  }
+
+  T exchange(T value, std::memory_order order = std::memory_order_seq_cst) {
+    Scheduler::instance().point();
+    return m_value.exchange(value, order);
+  }
+
+  bool compare_exchange_strong(T &expected, T desired,
+                               std::memory_order success,
+                               std::memory_order failure) {
+    Scheduler::instance().point();
+    return m_value.compare_exchange_strong(expected, desired, success,
+                                           failure);
+  }
+
+  bool compare_exchange_strong(
+      T &expected, T desired,
+      std::memory_order order = std::memory_order_seq_cst) {
+    Scheduler::instance().point();
+    return m_value.compare_exchange_strong(expected, desired, order);
+  }
+
+  bool compare_exchange_weak(T &expected, T desired,
+                             std::memory_order success,
+                             std::memory_order failure) {
+    Scheduler::instance().point();
+    if (Scheduler::instance().spurious_failure()) {
+      expected = m_value.load(failure);
+      return false;
+    }
+    return m_value.compare_exchange_strong(expected, desired, success,
+                                           failure);
+  }
+
+  bool compare_exchange_weak(
+      T &expected, T desired,
+      std::memory_order order = std::memory_order_seq_cst) {
+    return compare_exchange_weak(expected, desired, order,
+                                 failure_order(order));
+  }
+
+  T fetch_add(T arg, std::memory_order order = std::memory_order_seq_cst) {
+    Scheduler::instance().point();
+    return m_value.fetch_add(arg, order);
+  }
+
+  T fetch_sub(T arg, std::memory_order order = std::memory_order_seq_cst) {
+    Scheduler::instance().point();
+    return m_value.fetch_sub(arg, order);
+  }
+
+  operator T() const { return load(); }
+
+  T operator=(T value) {
+    store(value);
+    return value;
+  }
+
+private:
+  std::atomic<T> m_value;
+
+  static constexpr std::memory_order failure_order(std::memory_order order) {
+    if (order == std::memory_order_acq_rel) {
+      return std::memory_order_acquire;
+    }
+    if (order == std::memory_order_release) {
+      return std::memory_order_relaxed;
+    }
+    return order;
+  }
+};
+
+inline void atomic_thread_fence(std::memory_order order) {
+  Scheduler::instance().point();
+  std::atomic_thread_fence(order);
+}
+
+} // namespace lockfree::model
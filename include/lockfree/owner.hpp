@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__unix__) && !defined(LOCKFREE_MODEL_CHECK)
+#define LOCKFREE_HAS_PROCESS_OWNER
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace lockfree {
+
+// Owner tag of the indices taken from an IndexPool, used to reclaim the
+// indices of owners that died before they returned them (cf.
+// IndexPool::scavenge).
+//
+// The id identifies the owner and the epoch (31 bits) its incarnation, i.e.
+// an id may be reused by a new owner (with another epoch) without its
+// indices being reclaimed for the dead one. Id 0 is anonymous (never
+// reclaimed).
+struct Owner {
+  static constexpr uint32_t EPOCH_MASK = (1U << 31) - 1;
+
+  uint32_t id{0};
+  uint32_t epoch{0};
+
+  bool anonymous() const { return id == 0; }
+
+  bool operator==(const Owner &other) const {
+    return id == other.id && epoch == other.epoch;
+  }
+};
+
+#ifdef LOCKFREE_HAS_PROCESS_OWNER
+namespace detail {
+
+// start time of a process (clock ticks after boot, field 22 of
+// /proc/<pid>/stat, truncated to an epoch), 0 if unknown
+inline uint32_t process_start_time(pid_t pid) {
+  std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+  std::string stat;
+  if (!std::getline(file, stat)) {
+    return 0;
+  }
+  // the command (field 2) may contain spaces, the fields after it do not
+  auto end = stat.rfind(')');
+  if (end == std::string::npos) {
+    return 0;
+  }
+  std::istringstream fields(stat.substr(end + 1));
+  std::string field;
+  for (int i = 3; i <= 22 && fields >> field; ++i) {
+    if (i == 22) {
+      return static_cast<uint32_t>(std::stoull(field)) & Owner::EPOCH_MASK;
+    }
+  }
+  return 0;
+}
+
+// (packed, 0 if not determined yet)
+inline std::atomic<uint64_t> cached_process_owner{0};
+
+inline void reset_process_owner() {
+  cached_process_owner.store(0, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+// The owner of the calling process: its pid and its start time (a pid is
+// reused only by a process started later). All threads of a process share
+// the owner, since a thread cannot die without its process (C++ threads
+// cannot be killed).
+inline Owner process_owner() {
+  static const bool registered = [] {
+    // the child of a fork is another owner
+    pthread_atfork(nullptr, nullptr, &detail::reset_process_owner);
+    return true;
+  }();
+  (void)registered;
+  auto packed = detail::cached_process_owner.load(std::memory_order_relaxed);
+  if (packed == 0) {
+    auto pid = getpid();
+    packed = uint64_t(uint32_t(pid)) << 32 | detail::process_start_time(pid);
+    detail::cached_process_owner.store(packed, std::memory_order_relaxed);
+  }
+  return Owner{uint32_t(packed >> 32), uint32_t(packed)};
+}
+
+// whether the process of an owner (cf. process_owner) is still running
+// note: a zombie (not yet waited for) is still running
+inline bool process_alive(Owner owner) {
+  if (owner.anonymous()) {
+    return true;
+  }
+  auto pid = static_cast<pid_t>(owner.id);
+  if (kill(pid, 0) != 0 && errno != EPERM) {
+    return false;
+  }
+  // the pid may have been reused by another process
+  auto start = detail::process_start_time(pid);
+  return start == 0 || owner.epoch == 0 || start == owner.epoch;
+}
+#endif
+
+} // namespace lockfree
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "lockfree/reclamation.hpp"
+
+namespace lockfree {
+
+// Exchange buffer holding a pointer to a dynamically allocated value
+// (like not_lockfree::TakeBuffer), the replaced values are reclaimed with a
+// reclamation domain (cf. reclamation.hpp), i.e. it also supports read.
+//
+// Unlike the ExchangeBuffer there is no fixed number of slots (any number of
+// readers can copy values concurrently) and T can be any copyable type.
+//
+// note: values are allocated with new, i.e. write is only lock-free if the
+//       allocator is
+// note: take copies the value since concurrent readers may still copy it
+// note: the domain has a record for at most MaxThreads concurrent
+//       operations (cf. reclamation.hpp), further operations wait (spin)
+//       until one of them is done. All buffers share the global domain by
+//       default, use a domain with a larger MaxThreads for many threads.
+template <class T, class Reclaimer = HazardPointerDomain<>>
+class PointerExchangeBuffer {
+public:
+  explicit PointerExchangeBuffer(Reclaimer &domain = Reclaimer::global())
+      : m_domain(domain) {}
+
+  PointerExchangeBuffer(const PointerExchangeBuffer &) = delete;
+  PointerExchangeBuffer &operator=(const PointerExchangeBuffer &) = delete;
+
+  // there must be no concurrent operations
+  ~PointerExchangeBuffer() { delete m_value.load(std::memory_order_acquire); }
+
+  bool write(const T &value) { return emplace(value); }
+
+  bool write(T &&value) { return emplace(std::move(value)); }
+
+  template <class... Args> bool emplace(Args &&...args) {
+    auto value = new (std::nothrow) T(std::forward<Args>(args)...);
+    if (!value) {
+      return false;
+    }
+    // release: publish the value, acquire: the replaced value is completely
+    // written before it is deleted
+    auto old = m_value.exchange(value, std::memory_order_acq_rel);
+    if (old) {
+      m_domain.retire(old);
+    }
+    return true;
+  }
+
+  bool try_write(const T &value) {
+    auto ptr = new (std::nothrow) T(value);
+    if (!ptr) {
+      return false;
+    }
+    T *expected = nullptr;
+    if (!m_value.compare_exchange_strong(expected, ptr,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+      delete ptr; // was never published
+      return false;
+    }
+    return true;
+  }
+
+  std::optional<T> take() {
+    auto guard = m_domain.guard();
+    // protect before we unpublish, the value is not deleted while we copy
+    auto value = guard.protect(m_value);
+    while (value) {
+      if (m_value.compare_exchange_weak(value, nullptr,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+        std::optional<T> ret(*value);
+        guard.reset();
+        m_domain.retire(value);
+        return ret;
+      }
+      value = guard.protect(m_value);
+    }
+    return std::nullopt;
+  }
+
+  std::optional<T> read() {
+    auto guard = m_domain.guard();
+    auto value = guard.protect(m_value);
+    if (!value) {
+      return std::nullopt;
+    }
+    return std::optional<T>(*value);
+  }
+
+  bool empty() const {
+    return m_value.load(std::memory_order_relaxed) == nullptr;
+  }
+
+private:
+  std::atomic<T *> m_value{nullptr};
+  Reclaimer &m_domain;
+};
+
+} // namespace lockfree
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <type_traits>
+
+#include "lockfree/index_pool.hpp"
+#include "lockfree/storage.hpp"
+
+namespace lockfree {
+
+// Bounded multi-producer multi-consumer FIFO queue with capacity C.
+//
+// The values are stored in Storage slots obtained from the IndexPool (like
+// in the ExchangeBuffer) and only their indices are queued in a ring of
+// tagged indices (cf. the index queue of iceoryx).
+//
+// The counter of a cell is the position (sequence number) of the push that
+// wrote the index into the cell. It avoids the ABA problem and determines
+// whether the cell can be written (it contains the index of the previous
+// round) or read (it contains the index of the current round).
+//
+// A push first writes the cell and then advances the tail, a pop advances the
+// head. Any thread which finds a written cell at the tail helps to advance
+// the tail, i.e. a thread interrupted during its push cannot block others.
+template <class T, uint32_t C = 8, class IndexPoolType = IndexPool<C>>
+class Queue {
+private:
+  using storage_t = Storage<T, C>;
+  using indexpool_t = IndexPoolType;
+  using index_t = typename indexpool_t::index_t;
+
+  static constexpr index_t NO_DATA = C;
+
+  static_assert(indexpool_t::CAPACITY == C);
+
+  static constexpr uint32_t ring_size() {
+    uint32_t size = 1;
+    while (size < C) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  // the positions are 32 bit and wrap around, a power of 2 ring size ensures
+  // that each position is mapped to the same cell after wrap-around
+  //
+  // the ring can hold at least C indices, since there are only C indices
+  // the cell at the tail is always popped in the previous round when we push
+  // (i.e. a push of an index never fails)
+  static constexpr uint32_t RING_SIZE = ring_size();
+
+  // maximum number of values transferred in a batch
+  static constexpr uint32_t MAX_BATCH_SIZE = RING_SIZE < 64 ? RING_SIZE : 64;
+
+  struct tagged_index {
+    index_t index;
+    uint32_t counter;
+  };
+
+  static_assert(std::atomic<tagged_index>::is_always_lock_free);
+
+  // next position to push to and to pop from
+  std::atomic<uint32_t> m_tail{0};
+  std::atomic<uint32_t> m_head{0};
+  std::atomic<tagged_index> m_cells[RING_SIZE];
+  indexpool_t m_indices;
+  storage_t m_storage;
+
+public:
+  Queue() {
+    // initially the cells contain no data of the previous round
+    for (uint32_t position = 0; position < RING_SIZE; ++position) {
+      m_cells[position].store(tagged_index{NO_DATA, position - RING_SIZE},
+                              std::memory_order_relaxed);
+    }
+  }
+
+  // push value to the back of the queue
+  // returns false if the queue is full
+  bool try_push(const T &value) {
+    auto maybeIndex = m_indices.get();
+    if (!maybeIndex) {
+      return false; // full
+    }
+    auto index = maybeIndex.value();
+    m_storage.store_at(value, index);
+
+    auto position = m_tail.load(std::memory_order_acquire);
+    push_index(index, position);
+    return true;
+  }
+
+  // pop value from the front of the queue
+  // returns nullopt if the queue is empty
+  std::optional<T> try_pop() {
+    index_t index;
+    if (pop_indices(&index, 1) == 0) {
+      return std::nullopt;
+    }
+    std::optional<T> ret(std::move(m_storage[index]));
+    free(index);
+    return ret;
+  }
+
+  // push up to n values (in order), consecutive values are pushed at
+  // consecutive positions without reloading the tail if possible
+  // returns the number of values pushed (less than n if the queue is full)
+  uint32_t try_push_batch(const T *values, uint32_t n) {
+    uint32_t numPushed = 0;
+    auto position = m_tail.load(std::memory_order_acquire);
+    for (; numPushed < n; ++numPushed) {
+      auto maybeIndex = m_indices.get();
+      if (!maybeIndex) {
+        break; // full
+      }
+      auto index = maybeIndex.value();
+      m_storage.store_at(values[numPushed], index);
+      position = push_index(index, position) + 1;
+    }
+    return numPushed;
+  }
+
+  // pop up to n values (in order) with a single update of the head
+  // returns the number of values popped (less than n if the queue is empty or
+  // n exceeds the maximum batch size)
+  uint32_t try_pop_batch(T *values, uint32_t n) {
+    index_t indices[MAX_BATCH_SIZE];
+    if (n > MAX_BATCH_SIZE) {
+      n = MAX_BATCH_SIZE;
+    }
+
+    auto numPopped = pop_indices(indices, n);
+    for (uint32_t i = 0; i < numPopped; ++i) {
+      values[i] = std::move(m_storage[indices[i]]);
+      free(indices[i]);
+    }
+    return numPopped;
+  }
+
+  // note: only a snapshot, may be outdated immediately
+  bool empty() {
+    auto position = m_head.load(std::memory_order_relaxed);
+    auto cell = m_cells[position % RING_SIZE].load(std::memory_order_relaxed);
+    return cell.counter != position;
+  }
+
+private:
+  // push index starting at the (expected) tail position
+  // returns the position the index was pushed at
+  //
+  // memory order: the cell publishes the value (release/acquire), the tail
+  // is advanced with release and loaded with acquire, i.e. a push at the tail
+  // happens after the pushes of the previous positions
+  uint32_t push_index(index_t index, uint32_t position) {
+    while (true) {
+      auto &cell = m_cells[position % RING_SIZE];
+      auto old = cell.load(std::memory_order_acquire);
+
+      if (old.counter == position - RING_SIZE) {
+        // the cell is free (contains the popped index of the previous round)
+        // (a spurious failure retries at the current tail)
+        if (cell.compare_exchange_weak(old, tagged_index{index, position},
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+          advance_tail(position);
+          return position;
+        }
+        // someone else pushed at this position
+      }
+
+      if (old.counter == position) {
+        // another push wrote the cell, help to advance the tail
+        advance_tail(position);
+      }
+
+      // retry at the current tail
+      position = m_tail.load(std::memory_order_acquire);
+    }
+  }
+
+  // advance the tail beyond a written cell,
+  // fails if someone else advanced it already
+  void advance_tail(uint32_t position) {
+    m_tail.compare_exchange_strong(position, position + 1,
+                                   std::memory_order_release,
+                                   std::memory_order_relaxed);
+  }
+
+  // pop up to n consecutive indices with a single update of the head
+  //
+  // memory order: the cells are loaded with acquire to see the values, the
+  // head is loaded with acquire and updated with acq_rel, i.e. pops at
+  // consecutive positions are ordered like the pushes
+  uint32_t pop_indices(index_t *indices, uint32_t n) {
+    auto position = m_head.load(std::memory_order_acquire);
+    while (true) {
+      // collect the consecutive cells which are written in this round
+      uint32_t numReady = 0;
+      for (; numReady < n; ++numReady) {
+        auto &cell = m_cells[(position + numReady) % RING_SIZE];
+        auto current = cell.load(std::memory_order_acquire);
+        if (current.counter != position + numReady) {
+          break;
+        }
+        indices[numReady] = current.index;
+      }
+
+      if (numReady == 0) {
+        auto &cell = m_cells[position % RING_SIZE];
+        if (cell.load(std::memory_order_acquire).counter ==
+            position - RING_SIZE) {
+          return 0; // empty, the cell was not yet pushed in this round
+        }
+        // the head is outdated
+        position = m_head.load(std::memory_order_acquire);
+        continue;
+      }
+
+      // claim the indices, the cells cannot be overwritten before the head
+      // advanced beyond them (i.e. the indices are valid if the CAS succeeds)
+      if (m_head.compare_exchange_weak(position, position + numReady,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        return numReady;
+      }
+      // position was updated by the CAS, retry
+    }
+  }
+
+  void free(index_t index) {
+    m_storage.free(index);
+    m_indices.free(index);
+  }
+};
+
+} // namespace lockfree
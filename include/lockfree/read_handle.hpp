@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lockfree {
+
+// Handle to a value in a storage slot of a buffer (Owner) that is read in
+// place instead of being copied out (zero-copy read).
+// The slot is pinned, i.e. it cannot be freed or reused by the buffer as long
+// as the handle exists. It is released when the handle is destroyed or reset.
+template <class T, class Owner> class ReadHandle {
+public:
+  // empty handle (the buffer had no value)
+  ReadHandle() = default;
+
+  ReadHandle(const ReadHandle &) = delete;
+  ReadHandle &operator=(const ReadHandle &) = delete;
+
+  ReadHandle(ReadHandle &&other) noexcept
+      : m_owner(other.m_owner), m_index(other.m_index), m_ptr(other.m_ptr) {
+    other.m_owner = nullptr;
+  }
+
+  ReadHandle &operator=(ReadHandle &&other) noexcept {
+    if (this != &other) {
+      reset();
+      m_owner = other.m_owner;
+      m_index = other.m_index;
+      m_ptr = other.m_ptr;
+      other.m_owner = nullptr;
+    }
+    return *this;
+  }
+
+  ~ReadHandle() { reset(); }
+
+  explicit operator bool() const { return has_value(); }
+
+  bool has_value() const { return m_owner != nullptr; }
+
+  const T &operator*() const { return *m_ptr; }
+  const T *operator->() const { return m_ptr; }
+
+  // release the slot
+  void reset() {
+    if (m_owner) {
+      m_owner->release(m_index);
+      m_owner = nullptr;
+    }
+  }
+
+private:
+  friend Owner;
+
+  ReadHandle(Owner *owner, uint32_t index, const T *ptr)
+      : m_owner(owner), m_index(index), m_ptr(ptr) {}
+
+  Owner *m_owner{nullptr};
+  uint32_t m_index{0};
+  const T *m_ptr{nullptr};
+};
+
+} // namespace lockfree
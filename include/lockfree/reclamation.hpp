@@ -0,0 +1,533 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "lockfree/layout.hpp"
+
+namespace lockfree {
+
+// Safe memory reclamation for structures that unlink dynamically allocated
+// objects while other threads may still access them (e.g. a pointer to the
+// current value or the nodes of a list).
+//
+// A thread accesses an object only through a guard, and objects are retired
+// after they were unlinked instead of being deleted. A retired object is
+// deleted once no guard can reference it anymore. This also prevents the ABA
+// problem since the address of a guarded object cannot be reused.
+//
+// Both domains have the same interface and can be plugged into a structure
+// as template parameter (cf. PointerExchangeBuffer):
+//
+//   auto guard = domain.guard();
+//   T *ptr = guard.protect(atomicPtr); // valid until the guard is reset
+//   ...
+//   domain.retire(unlinkedPtr);         // deleted when it is safe
+//
+// - HazardPointerDomain: a guard publishes the pointer it protects (hazard
+//   pointer), a scan deletes the retired objects no hazard pointer refers to.
+//   The number of retired objects is bounded, even if a thread stalls while
+//   holding a guard (robust).
+// - EpochDomain: a guard marks a critical section with the global epoch, an
+//   object retired in epoch e is deleted once the epoch reached e + 2 (all
+//   threads left the critical sections that could reference it). Guards are
+//   cheaper (no validation per pointer), but a thread stalled in a critical
+//   section blocks all reclamation (the retire lists grow meanwhile).
+//
+// Each thread claims a record of the domain on first use. The record holds
+// the retired objects of the thread (retire list), which are scanned in
+// batches when it is full. Records (including their retired objects) are
+// released when the thread exits and adopted by the next thread.
+// Up to MaxThreads / 2 threads keep their record, further threads claim a
+// record per operation (a CAS more). Any number of threads can use a domain,
+// but an operation waits for a free record while MaxThreads operations (or
+// guards) are in progress.
+//
+// note: all threads that used a domain must have exited before it is
+//       destroyed (except for the destroying thread), the domain deletes all
+//       remaining retired objects
+
+namespace detail {
+
+struct Retired {
+  void *ptr;
+  void (*deleter)(void *);
+
+  void reclaim() { deleter(ptr); }
+};
+
+template <class T> void delete_object(void *ptr) { delete static_cast<T *>(ptr); }
+
+// Records of a domain claimed by the threads, the claimed records are
+// cached per thread (for up to MAX_DOMAINS_PER_THREAD domains, for further
+// domains a record is claimed per operation)
+//
+// At most MAX_CACHED records are cached, further threads claim a record per
+// operation. Hence a thread only waits for a record while the other records
+// are used by operations in progress, not until cached records are released
+// by exiting threads.
+template <class Domain, class Record, uint32_t MaxThreads>
+class RecordRegistry {
+public:
+  static constexpr uint32_t MAX_DOMAINS_PER_THREAD = 4;
+  static constexpr uint32_t MAX_CACHED = MaxThreads / 2;
+
+  // record of the calling thread, must be returned with put
+  Record *get() {
+    auto &cache = t_cache;
+    for (auto &entry : cache.entries) {
+      if (entry.registry == this) {
+        return entry.record;
+      }
+    }
+    auto record = claim();
+    for (auto &entry : cache.entries) {
+      if (!entry.registry) {
+        if (reserve_cached()) {
+          entry = {this, record};
+          return record;
+        }
+        break;
+      }
+    }
+    record->temporary = true;
+    return record;
+  }
+
+  void put(Record *record) {
+    if (record->temporary) {
+      record->temporary = false;
+      unclaim(record);
+    }
+  }
+
+  // remove the record of the calling thread from its cache
+  void forget() {
+    for (auto &entry : t_cache.entries) {
+      if (entry.registry == this) {
+        uncache(entry.record);
+        entry = {};
+      }
+    }
+  }
+
+  Record *begin() { return m_records; }
+  Record *end() { return m_records + MaxThreads; }
+
+private:
+  struct Entry {
+    RecordRegistry *registry{nullptr};
+    Record *record{nullptr};
+  };
+
+  struct ThreadCache {
+    Entry entries[MAX_DOMAINS_PER_THREAD];
+
+    // release the records (and their retired objects) when the thread exits
+    ~ThreadCache() {
+      for (auto &entry : entries) {
+        if (entry.registry) {
+          entry.registry->uncache(entry.record);
+        }
+      }
+    }
+  };
+
+  static inline thread_local ThreadCache t_cache;
+
+  Record m_records[MaxThreads];
+  std::atomic<uint32_t> m_numCached{0};
+
+  bool reserve_cached() {
+    auto numCached = m_numCached.load(std::memory_order_relaxed);
+    while (numCached < MAX_CACHED) {
+      if (m_numCached.compare_exchange_weak(numCached, numCached + 1,
+                                            std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void uncache(Record *record) {
+    unclaim(record);
+    m_numCached.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  Record *claim() {
+    while (true) {
+      for (auto &record : m_records) {
+        bool expected = false;
+        // acquire: we adopt the retired objects of the previous owner
+        if (!record.claimed.load(std::memory_order_relaxed) &&
+            record.claimed.compare_exchange_strong(
+                expected, true, std::memory_order_acquire,
+                std::memory_order_relaxed)) {
+          return &record;
+        }
+      }
+      // all records are used by operations in progress
+      std::this_thread::yield();
+    }
+  }
+
+  void unclaim(Record *record) {
+    record->claimed.store(false, std::memory_order_release);
+  }
+};
+
+} // namespace detail
+
+template <uint32_t MaxThreads = 32, uint32_t HazardsPerThread = 2>
+class HazardPointerDomain {
+private:
+  static constexpr uint32_t NUM_HAZARDS = MaxThreads * HazardsPerThread;
+  // a scan of a full list deletes at least half of it (at most NUM_HAZARDS
+  // objects are protected), i.e. the amortized cost of retire is constant
+  static constexpr uint32_t RETIRE_CAPACITY = 2 * NUM_HAZARDS;
+
+  static_assert(HazardsPerThread > 0 && HazardsPerThread <= 32);
+
+  struct alignas(CACHE_LINE_SIZE) Record {
+    std::atomic<bool> claimed{false};
+    std::atomic<void *> hazards[HazardsPerThread]{};
+    // only accessed by the owning thread
+    bool temporary{false};
+    uint32_t usedHazards{0};
+    uint32_t numRetired{0};
+    detail::Retired retired[RETIRE_CAPACITY];
+  };
+
+  using registry_t =
+      detail::RecordRegistry<HazardPointerDomain, Record, MaxThreads>;
+
+public:
+  // protects one pointer at a time (at most HazardsPerThread guards per
+  // thread)
+  class Guard {
+  public:
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+    Guard(Guard &&other) noexcept
+        : m_domain(other.m_domain), m_record(other.m_record),
+          m_slot(other.m_slot) {
+      other.m_domain = nullptr;
+    }
+
+    ~Guard() {
+      if (m_domain) {
+        reset();
+        m_record->usedHazards &= ~(1U << m_slot);
+        m_domain->m_records.put(m_record);
+      }
+    }
+
+    // load the pointer and protect the object it points to
+    template <class T> T *protect(const std::atomic<T *> &src) {
+      auto &hazard = m_record->hazards[m_slot];
+      T *ptr = src.load(std::memory_order_relaxed);
+      while (true) {
+        // seq_cst: the hazard is visible to a scan before we validate, i.e.
+        // either the scan sees it or we see that the pointer was unlinked
+        hazard.store(ptr, std::memory_order_seq_cst);
+        T *current = src.load(std::memory_order_seq_cst);
+        if (current == ptr) {
+          return ptr;
+        }
+        ptr = current;
+      }
+    }
+
+    // the protected object may be deleted afterwards
+    void reset() {
+      m_record->hazards[m_slot].store(nullptr, std::memory_order_release);
+    }
+
+  private:
+    friend HazardPointerDomain;
+
+    Guard(HazardPointerDomain *domain, Record *record, uint32_t slot)
+        : m_domain(domain), m_record(record), m_slot(slot) {}
+
+    HazardPointerDomain *m_domain;
+    Record *m_record;
+    uint32_t m_slot;
+  };
+
+  using guard_t = Guard;
+
+  HazardPointerDomain() = default;
+
+  HazardPointerDomain(const HazardPointerDomain &) = delete;
+  HazardPointerDomain &operator=(const HazardPointerDomain &) = delete;
+
+  ~HazardPointerDomain() {
+    m_records.forget();
+    for (auto &record : m_records) {
+      for (uint32_t i = 0; i < record.numRetired; ++i) {
+        record.retired[i].reclaim();
+      }
+    }
+  }
+
+  // domain shared by all structures using the default
+  static HazardPointerDomain &global() {
+    static HazardPointerDomain domain;
+    return domain;
+  }
+
+  Guard guard() {
+    auto record = m_records.get();
+    for (uint32_t slot = 0; slot < HazardsPerThread; ++slot) {
+      if (!(record->usedHazards & (1U << slot))) {
+        record->usedHazards |= 1U << slot;
+        return Guard(this, record, slot);
+      }
+    }
+    assert(false && "more guards than HazardsPerThread");
+    std::abort();
+  }
+
+  // delete the (unlinked) object when no guard protects it anymore
+  template <class T> void retire(T *ptr) {
+    retire(ptr, &detail::delete_object<T>);
+  }
+
+  void retire(void *ptr, void (*deleter)(void *)) {
+    auto record = m_records.get();
+    record->retired[record->numRetired++] = {ptr, deleter};
+    if (record->numRetired == RETIRE_CAPACITY) {
+      scan(record);
+    }
+    m_records.put(record);
+  }
+
+  // delete the objects retired by the calling thread that are not protected
+  void reclaim() {
+    auto record = m_records.get();
+    scan(record);
+    m_records.put(record);
+  }
+
+private:
+  registry_t m_records;
+
+  void scan(Record *record) {
+    // pairs with the store of the hazard (cf. protect), objects are retired
+    // after they are unlinked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    void *hazards[NUM_HAZARDS];
+    uint32_t numHazards = 0;
+    for (auto &other : m_records) {
+      for (auto &hazard : other.hazards) {
+        if (auto ptr = hazard.load(std::memory_order_acquire)) {
+          hazards[numHazards++] = ptr;
+        }
+      }
+    }
+    std::sort(hazards, hazards + numHazards);
+
+    // the deleters may retire further objects
+    detail::Retired reclaimable[RETIRE_CAPACITY];
+    uint32_t numReclaimable = 0;
+    uint32_t numKept = 0;
+    for (uint32_t i = 0; i < record->numRetired; ++i) {
+      auto &retired = record->retired[i];
+      if (std::binary_search(hazards, hazards + numHazards, retired.ptr)) {
+        record->retired[numKept++] = retired;
+      } else {
+        reclaimable[numReclaimable++] = retired;
+      }
+    }
+    record->numRetired = numKept;
+    for (uint32_t i = 0; i < numReclaimable; ++i) {
+      reclaimable[i].reclaim();
+    }
+  }
+};
+
+// BatchSize retired objects of a thread are scanned at once
+template <uint32_t MaxThreads = 32, uint32_t BatchSize = 128>
+class EpochDomain {
+private:
+  static_assert(BatchSize > 0);
+
+  // epoch 0 marks a thread outside of critical sections
+  static constexpr uint64_t QUIESCENT = 0;
+
+  struct Retired {
+    detail::Retired object;
+    uint64_t epoch;
+  };
+
+  struct alignas(CACHE_LINE_SIZE) Record {
+    std::atomic<bool> claimed{false};
+    std::atomic<uint64_t> epoch{QUIESCENT};
+    // only accessed by the owning thread
+    bool temporary{false};
+    uint32_t nesting{0};
+    // allocates only if reclamation is blocked (more than BatchSize objects
+    // cannot be deleted)
+    std::vector<Retired> retired;
+
+    Record() { retired.reserve(BatchSize); }
+  };
+
+  using registry_t = detail::RecordRegistry<EpochDomain, Record, MaxThreads>;
+
+public:
+  // critical section, all pointers loaded while the guard exists are
+  // protected (guards of a thread may be nested)
+  class Guard {
+  public:
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+    Guard(Guard &&other) noexcept
+        : m_domain(other.m_domain), m_record(other.m_record) {
+      other.m_domain = nullptr;
+    }
+
+    ~Guard() { reset(); }
+
+    template <class T> T *protect(const std::atomic<T *> &src) {
+      return src.load(std::memory_order_acquire);
+    }
+
+    // leave the critical section
+    void reset() {
+      if (!m_domain) {
+        return;
+      }
+      if (--m_record->nesting == 0) {
+        // release: our accesses are done before the epoch may advance
+        m_record->epoch.store(QUIESCENT, std::memory_order_release);
+      }
+      m_domain->m_records.put(m_record);
+      m_domain = nullptr;
+    }
+
+  private:
+    friend EpochDomain;
+
+    Guard(EpochDomain *domain, Record *record)
+        : m_domain(domain), m_record(record) {}
+
+    EpochDomain *m_domain;
+    Record *m_record;
+  };
+
+  using guard_t = Guard;
+
+  EpochDomain() = default;
+
+  EpochDomain(const EpochDomain &) = delete;
+  EpochDomain &operator=(const EpochDomain &) = delete;
+
+  ~EpochDomain() {
+    m_records.forget();
+    for (auto &record : m_records) {
+      for (auto &retired : record.retired) {
+        retired.object.reclaim();
+      }
+    }
+  }
+
+  // domain shared by all structures using the default
+  static EpochDomain &global() {
+    static EpochDomain domain;
+    return domain;
+  }
+
+  Guard guard() {
+    auto record = m_records.get();
+    if (record->nesting++ == 0) {
+      record->epoch.store(m_epoch.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+      // the epoch is visible before we load any pointer (cf. try_advance)
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    return Guard(this, record);
+  }
+
+  template <class T> void retire(T *ptr) {
+    retire(ptr, &detail::delete_object<T>);
+  }
+
+  void retire(void *ptr, void (*deleter)(void *)) {
+    auto record = m_records.get();
+    // the object was unlinked before (e.g. with an acq_rel exchange, which
+    // does not order our load of the epoch), a stale epoch would delete it
+    // too early (cf. guard)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    record->retired.push_back(
+        {{ptr, deleter}, m_epoch.load(std::memory_order_relaxed)});
+    if (record->retired.size() % BatchSize == 0) {
+      try_advance();
+      scan(record);
+    }
+    m_records.put(record);
+  }
+
+  // delete the objects retired by the calling thread that cannot be
+  // referenced anymore
+  void reclaim() {
+    auto record = m_records.get();
+    try_advance();
+    scan(record);
+    m_records.put(record);
+  }
+
+private:
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_epoch{1};
+  registry_t m_records;
+
+  // advance the epoch if all threads in critical sections observed it
+  void try_advance() {
+    auto epoch = m_epoch.load(std::memory_order_seq_cst);
+    for (auto &record : m_records) {
+      auto local = record.epoch.load(std::memory_order_seq_cst);
+      if (local != QUIESCENT && local != epoch) {
+        return;
+      }
+    }
+    m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed);
+  }
+
+  // objects retired in epoch e are unreachable for critical sections that
+  // started in epoch e + 1 or later, once the epoch is e + 2 all others ended
+  void scan(Record *record) {
+    auto epoch = m_epoch.load(std::memory_order_acquire);
+    // the deleters may retire further objects
+    detail::Retired reclaimable[BatchSize];
+    auto &retired = record->retired;
+    while (true) {
+      uint32_t numReclaimable = 0;
+      size_t numKept = 0;
+      for (size_t i = 0; i < retired.size(); ++i) {
+        if (retired[i].epoch + 2 <= epoch && numReclaimable < BatchSize) {
+          reclaimable[numReclaimable++] = retired[i].object;
+        } else {
+          retired[numKept++] = retired[i];
+        }
+      }
+      retired.resize(numKept);
+      for (uint32_t i = 0; i < numReclaimable; ++i) {
+        reclaimable[i].reclaim();
+      }
+      if (numReclaimable < BatchSize) {
+        return;
+      }
+    }
+  }
+};
+
+} // namespace lockfree
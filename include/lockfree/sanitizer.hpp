@@ -0,0 +1,35 @@
+#pragma once
+
+// Support for ThreadSanitizer (cf. the LOCKFREE_TSAN build option).
+//
+// Copies of values which may be overwritten concurrently and are validated
+// afterwards (like in a seqlock) are data races by definition. The torn copies
+// are discarded, but ThreadSanitizer reports them unless the reads are
+// ignored explicitly.
+
+#if defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define LOCKFREE_TSAN_ENABLED
+#endif
+#endif
+
+#if defined(__SANITIZE_THREAD__) && !defined(LOCKFREE_TSAN_ENABLED)
+#define LOCKFREE_TSAN_ENABLED
+#endif
+
+#ifdef LOCKFREE_TSAN_ENABLED
+// dynamic annotations of the ThreadSanitizer runtime
+extern "C" void AnnotateIgnoreReadsBegin(const char *file, int line);
+extern "C" void AnnotateIgnoreReadsEnd(const char *file, int line);
+
+#define LOCKFREE_IGNORE_READS_BEGIN()                                          \
+  AnnotateIgnoreReadsBegin(__FILE__, __LINE__)
+#define LOCKFREE_IGNORE_READS_END() AnnotateIgnoreReadsEnd(__FILE__, __LINE__)
+#else
+#define LOCKFREE_IGNORE_READS_BEGIN()                                          \
+  do {                                                                         \
+  } while (0)
+#define LOCKFREE_IGNORE_READS_END()                                            \
+  do {                                                                         \
+  } while (0)
+#endif
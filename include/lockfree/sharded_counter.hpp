@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "lockfree/layout.hpp"
+#include "lockfree/sync_counter.hpp"
+
+namespace lockfree {
+
+// single counter per shard, increments are a relaxed fetch_add
+// (the counter does not publish other data)
+class alignas(CACHE_LINE_SIZE) RelaxedShard {
+public:
+  void increment() { m_count.fetch_add(1, std::memory_order_relaxed); }
+
+  uint64_t sync() { return m_count.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> m_count{0};
+};
+
+// Counter distributed over padded shards to avoid contention of increments.
+// Each thread increments the shard assigned to it (round robin), i.e. there is
+// no contention as long as there are at most as many threads as shards. The
+// number of shards defaults to the number of cores (rounded up to a power of
+// two), the footprint is one cache line per shard (two with SyncCounter
+// shards).
+//
+// Shard can be any type with increment() and sync(), e.g. SyncCounter to keep
+// the two-counter helping invariant per shard (sync() of the shard completes
+// partial increments).
+template <class Shard = RelaxedShard> class ShardedCounter {
+public:
+  explicit ShardedCounter(
+      uint32_t shards = std::thread::hardware_concurrency()) {
+    uint32_t size = 1;
+    while (size < shards) {
+      size *= 2;
+    }
+    m_mask = size - 1;
+    m_shards = std::make_unique<Shard[]>(size);
+  }
+
+  void increment() { m_shards[thread_id() & m_mask].increment(); }
+
+  // sum of the shards, only a snapshot if there are no concurrent increments
+  // (but between the values before and after the call otherwise)
+  uint64_t get() {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i <= m_mask; ++i) {
+      sum += m_shards[i].sync();
+    }
+    return sum;
+  }
+
+  // consistent value: the shards only grow, i.e. if two consecutive sums are
+  // equal no shard changed in between and the sum is the value of the counter
+  // at a point between both (double collect)
+  // note: may retry as long as there are concurrent increments
+  uint64_t sync() {
+    uint64_t sum = get();
+    while (true) {
+      uint64_t current = get();
+      if (current == sum) {
+        return sum;
+      }
+      sum = current;
+    }
+  }
+
+  uint32_t shards() const { return m_mask + 1; }
+
+private:
+  uint32_t m_mask;
+  std::unique_ptr<Shard[]> m_shards;
+
+  // threads are assigned to shards in the order of their first increment
+  static uint32_t thread_id() {
+    static std::atomic<uint32_t> next{0};
+    thread_local uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+  }
+};
+
+} // namespace lockfree
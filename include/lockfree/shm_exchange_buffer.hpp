@@ -0,0 +1,331 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lockfree/exchange_buffer.hpp"
+#include "lockfree/layout.hpp"
+
+namespace lockfree {
+
+// ExchangeBuffer in a POSIX shared memory segment to exchange values between
+// processes (zero-copy with loan/publish and read handles).
+//
+// The buffer holds no pointers (only indices into its Storage) and its
+// atomics are address-free, i.e. each process may map the segment at another
+// address. T must not contain pointers into the memory of a process.
+//
+// Segment layout: a header (magic, version and the layout parameters of the
+// buffer, checked on attach) followed by the buffer at the next cache line.
+// The creator initializes the segment and marks it READY, attach waits for
+// this (at most for a timeout).
+//
+// Recovery: the header holds a table of the participating processes. A
+// process that dies while it holds a slot leaks it and the buffer has one
+// slot less (write fails once all are leaked).
+// - scavenge() reclaims the slots that dead processes took but did not
+//   publish (e.g. loans) while other processes keep using the buffer
+//   (the slots of the IndexPool are tagged with their owning process)
+// - slots held by read handles or taken but not yet copied cannot be
+//   attributed to a process. Once all other participants are dead, reset()
+//   reinitializes the buffer in place (empty) without recreating the
+//   segment, the processes attached later use it as usual.
+//
+// note: dead processes are detected by pid, i.e. a zombie (not yet waited
+//       for) or a reused pid counts as alive (reset conservatively fails)
+// note: the segment is removed with remove(), existing mappings stay valid
+template <class T, uint32_t C = 8, class IndexPoolType = IndexPool<C>,
+          class Backoff = NoBackoff>
+class ShmExchangeBuffer {
+public:
+  using buffer_t = ExchangeBuffer<T, C, IndexPoolType, Backoff>;
+
+  // values are copied between processes byte by byte and reclaimed slots are
+  // not destroyed
+  static_assert(std::is_trivially_copyable<T>::value);
+
+  static constexpr uint32_t MAGIC = 0x4245464c; // "LFEB"
+  static constexpr uint32_t VERSION = 2;
+  static constexpr uint32_t MAX_PARTICIPANTS = 16;
+
+private:
+  enum State : uint32_t { INITIALIZING = 0, READY = 1, RESETTING = 2 };
+
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;
+    uint32_t valueSize;
+    uint32_t valueAlign;
+    uint32_t capacity;
+    std::atomic<uint32_t> state;
+    // incremented by each reset
+    std::atomic<uint32_t> generation;
+    // pids of the attached processes (0 if unused)
+    std::atomic<pid_t> participants[MAX_PARTICIPANTS];
+  };
+
+  static_assert(std::atomic<uint32_t>::is_always_lock_free);
+  static_assert(std::atomic<pid_t>::is_always_lock_free);
+
+  static constexpr std::size_t BUFFER_OFFSET =
+      (sizeof(Header) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE *
+      CACHE_LINE_SIZE;
+  static_assert(alignof(buffer_t) <= CACHE_LINE_SIZE);
+
+public:
+  static constexpr std::size_t SEGMENT_SIZE = BUFFER_OFFSET + sizeof(buffer_t);
+
+  // create and initialize the segment, fails if it exists already
+  static std::optional<ShmExchangeBuffer> create(const std::string &name,
+                                                 mode_t mode = 0600) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, mode);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, SEGMENT_SIZE) == 0) {
+      addr = mmap(nullptr, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+      shm_unlink(name.c_str());
+      return std::nullopt;
+    }
+
+    // the segment is zeroed by ftruncate, i.e. attaching processes see
+    // INITIALIZING, generation 0 and no participants
+    // (the zeroed atomics are not written again, a concurrent attach may
+    // already wait for READY)
+    auto header = static_cast<Header *>(addr);
+    header->magic = MAGIC;
+    header->version = VERSION;
+    header->size = SEGMENT_SIZE;
+    header->valueSize = sizeof(T);
+    header->valueAlign = alignof(T);
+    header->capacity = C;
+    new (buffer_ptr(addr)) buffer_t(process_shared);
+
+    ShmExchangeBuffer shm(addr);
+    shm.enter();
+    // release: the initialized segment is visible to attaching processes
+    header->state.store(READY, std::memory_order_release);
+    return shm;
+  }
+
+  // attach to an existing segment, fails if it does not exist, is not
+  // initialized within timeout, belongs to a buffer of another layout or has
+  // no free participant entry
+  template <class Rep = int64_t, class Period = std::milli>
+  static std::optional<ShmExchangeBuffer>
+  attach(const std::string &name, const std::chrono::duration<Rep, Period>
+                                      &timeout = std::chrono::seconds(1)) {
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now() + timeout;
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+    // the creator may not have sized the segment yet
+    struct stat st {};
+    while (true) {
+      if (fstat(fd, &st) != 0) {
+        close(fd);
+        return std::nullopt;
+      }
+      if (st.st_size != 0 || clock::now() >= deadline) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+    void *addr = MAP_FAILED;
+    if (st.st_size == static_cast<off_t>(SEGMENT_SIZE)) {
+      addr = mmap(nullptr, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+      return std::nullopt;
+    }
+
+    ShmExchangeBuffer shm(addr);
+    // the header is written before the segment is READY, we only enter the
+    // participant table of an initialized segment of our layout
+    if (!shm.wait_ready(deadline) || !shm.compatible() || !shm.enter()) {
+      return std::nullopt;
+    }
+    // seq_cst: either a concurrent reset sees our entry or we see that the
+    // buffer is RESETTING and wait (cf. reset)
+    if (!shm.wait_ready(deadline)) {
+      return std::nullopt;
+    }
+    return shm;
+  }
+
+  // remove the segment name (mappings stay valid until they are released)
+  static bool remove(const std::string &name) {
+    return shm_unlink(name.c_str()) == 0;
+  }
+
+  ShmExchangeBuffer(const ShmExchangeBuffer &) = delete;
+  ShmExchangeBuffer &operator=(const ShmExchangeBuffer &) = delete;
+
+  ShmExchangeBuffer(ShmExchangeBuffer &&other) noexcept
+      : m_addr(other.m_addr), m_entry(other.m_entry) {
+    other.m_addr = nullptr;
+  }
+
+  ShmExchangeBuffer &operator=(ShmExchangeBuffer &&other) noexcept {
+    if (this != &other) {
+      detach();
+      m_addr = other.m_addr;
+      m_entry = other.m_entry;
+      other.m_addr = nullptr;
+    }
+    return *this;
+  }
+
+  ~ShmExchangeBuffer() { detach(); }
+
+  buffer_t &operator*() { return *buffer(); }
+  buffer_t *operator->() { return buffer(); }
+
+  uint32_t generation() const {
+    return header().generation.load(std::memory_order_acquire);
+  }
+
+  // number of participants that died without detaching
+  uint32_t dead_participants() const {
+    uint32_t count = 0;
+    for (auto &participant : header().participants) {
+      auto pid = participant.load(std::memory_order_acquire);
+      if (pid != 0 && !alive(pid)) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  // reclaim the slots of dead processes (cf. ExchangeBuffer::scavenge) and
+  // remove them from the participants, returns the number of reclaimed slots
+  // lock-free, i.e. may run concurrently with the other processes
+  uint32_t scavenge() {
+    auto reclaimed = buffer()->scavenge();
+    for (auto &participant : header().participants) {
+      auto pid = participant.load(std::memory_order_acquire);
+      if (pid != 0 && !alive(pid)) {
+        participant.compare_exchange_strong(pid, 0, std::memory_order_relaxed);
+      }
+    }
+    return reclaimed;
+  }
+
+  // reinitialize the buffer (empty, all slots free) if all other
+  // participants are dead, fails otherwise (or if another reset is running)
+  bool reset() {
+    auto &h = header();
+    uint32_t expected = READY;
+    if (!h.state.compare_exchange_strong(expected, RESETTING,
+                                         std::memory_order_seq_cst)) {
+      return false;
+    }
+    // processes attaching from now on wait until we are done
+    for (uint32_t i = 0; i < MAX_PARTICIPANTS; ++i) {
+      auto pid = h.participants[i].load(std::memory_order_seq_cst);
+      if (i != m_entry && pid != 0 && alive(pid)) {
+        h.state.store(READY, std::memory_order_release);
+        return false;
+      }
+    }
+    for (uint32_t i = 0; i < MAX_PARTICIPANTS; ++i) {
+      auto pid = h.participants[i].load(std::memory_order_relaxed);
+      if (i != m_entry && pid != 0) {
+        // only dead entries (a concurrent attach may have taken a free one)
+        h.participants[i].compare_exchange_strong(pid, 0,
+                                                  std::memory_order_relaxed);
+      }
+    }
+    // values are trivially copyable, i.e. leaked slots need no destruction
+    auto ptr = buffer();
+    ptr->~buffer_t();
+    new (ptr) buffer_t(process_shared);
+    h.generation.fetch_add(1, std::memory_order_relaxed);
+    h.state.store(READY, std::memory_order_release);
+    return true;
+  }
+
+private:
+  void *m_addr{nullptr};
+  uint32_t m_entry{MAX_PARTICIPANTS};
+
+  explicit ShmExchangeBuffer(void *addr) : m_addr(addr) {}
+
+  static void *buffer_ptr(void *addr) {
+    return static_cast<char *>(addr) + BUFFER_OFFSET;
+  }
+
+  Header &header() const { return *static_cast<Header *>(m_addr); }
+
+  template <class TimePoint> bool wait_ready(const TimePoint &deadline) {
+    while (header().state.load(std::memory_order_seq_cst) != READY) {
+      if (TimePoint::clock::now() >= deadline) {
+        return false;
+      }
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  buffer_t *buffer() { return static_cast<buffer_t *>(buffer_ptr(m_addr)); }
+
+  static bool alive(pid_t pid) { return kill(pid, 0) == 0 || errno == EPERM; }
+
+  bool compatible() const {
+    auto &h = header();
+    return h.magic == MAGIC && h.version == VERSION && h.size == SEGMENT_SIZE &&
+           h.valueSize == sizeof(T) && h.valueAlign == alignof(T) &&
+           h.capacity == C;
+  }
+
+  // register in the participant table
+  bool enter() {
+    auto pid = getpid();
+    for (uint32_t i = 0; i < MAX_PARTICIPANTS; ++i) {
+      pid_t expected = 0;
+      if (header().participants[i].compare_exchange_strong(
+              expected, pid, std::memory_order_seq_cst)) {
+        m_entry = i;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void detach() {
+    if (!m_addr) {
+      return;
+    }
+    if (m_entry < MAX_PARTICIPANTS) {
+      header().participants[m_entry].store(0, std::memory_order_release);
+    }
+    munmap(m_addr, SEGMENT_SIZE);
+    m_addr = nullptr;
+  }
+};
+
+} // namespace lockfree
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <type_traits>
+
+#include "lockfree/layout.hpp"
+#include "lockfree/loan.hpp"
+#include "lockfree/read_handle.hpp"
+#include "lockfree/storage.hpp"
+
+namespace lockfree {
+
+// ExchangeBuffer for a single producer and a single consumer thread
+// (same interface, except that the capacity is fixed).
+//
+// Triple buffer: the producer owns a back slot it writes to, the consumer owns
+// a front slot it reads from and the middle slot is exchanged between them.
+// Publishing a value exchanges the back slot with the middle slot (marked as
+// FRESH), the consumer exchanges its front slot with a FRESH middle slot.
+// This requires only a single atomic exchange per operation and no index
+// allocation.
+//
+// The consumer owns a spare slot which is used for at most one read or take
+// handle at a time (further handle requests return an empty handle).
+//
+// note: all producer operations (write, emplace, loan, publish, try_write)
+//       must be called by the same thread, the same holds for the consumer
+//       operations (take, take_handle, read, read_handle) and the handles
+template <class T> class SpscExchangeBuffer {
+private:
+  static constexpr uint32_t NUM_SLOTS = 4;
+
+  using storage_t = Storage<T, NUM_SLOTS>;
+  using index_t = uint32_t;
+
+  static constexpr index_t NO_SLOT = NUM_SLOTS;
+  static constexpr index_t FRESH = 1U << 31;
+
+  static_assert(std::is_trivially_copyable<T>::value);
+
+  // producer
+  alignas(CACHE_LINE_SIZE) index_t m_back{0};
+  bool m_loaned{false};
+
+  // shared
+  alignas(CACHE_LINE_SIZE) std::atomic<index_t> m_middle{1};
+
+  // consumer (m_frontValid is also read by the producer)
+  alignas(CACHE_LINE_SIZE) std::atomic<bool> m_frontValid{false};
+  index_t m_front{2};
+  index_t m_spare{3};
+  index_t m_pinned{NO_SLOT};
+
+  storage_t m_storage;
+
+public:
+  using loan_t = Loan<T, SpscExchangeBuffer>;
+  using handle_t = ReadHandle<T, SpscExchangeBuffer>;
+
+  bool write(const T &value) { return emplace(value); }
+
+  // construct the value in place and publish it (like write)
+  template <class... Args> bool emplace(Args &&...args) {
+    auto slot = loan();
+    if (!slot) {
+      return false; // back slot is loaned
+    }
+    slot.emplace(std::forward<Args>(args)...);
+    return publish(std::move(slot));
+  }
+
+  // obtain the back slot to construct a value in place,
+  // the loan is invalid if the back slot is already loaned
+  loan_t loan() {
+    if (m_loaned) {
+      return loan_t();
+    }
+    m_loaned = true;
+    return loan_t(this, m_back, m_storage.ptr(m_back));
+  }
+
+  // publish the value constructed in a loaned slot (like write)
+  // fails if the loan holds no value (or belongs to another buffer)
+  bool publish(loan_t &&loan) {
+    if (!loan.has_value() || loan.m_owner != this) {
+      return false;
+    }
+    loan.m_owner = nullptr;
+    m_loaned = false;
+
+    // release: the consumer sees the value
+    // acquire: the consumer is done with the slot we get back
+    auto old = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+    // an unconsumed value is overwritten (no need to destroy it since T is
+    // trivially copyable)
+    m_back = old & ~FRESH;
+    return true;
+  }
+
+  // only the producer adds values, i.e. the buffer stays empty until we write
+  bool try_write(const T &value) {
+    if (!empty()) {
+      return false;
+    }
+    return write(value);
+  }
+
+  std::optional<T> take() {
+    refresh();
+    if (!m_frontValid.load(std::memory_order_relaxed)) {
+      return std::nullopt;
+    }
+    // copy (not move) since a read handle may still read the front slot
+    std::optional<T> ret(m_storage[m_front]);
+    m_frontValid.store(false, std::memory_order_relaxed);
+    return ret;
+  }
+
+  bool take(T &out) {
+    refresh();
+    if (!m_frontValid.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    out = m_storage[m_front];
+    m_frontValid.store(false, std::memory_order_relaxed);
+    return true;
+  }
+
+  // take the value without copying it out of the buffer,
+  // the handle is empty if there is no value (or another handle exists)
+  handle_t take_handle() {
+    if (m_pinned != NO_SLOT) {
+      return handle_t();
+    }
+    refresh();
+    if (!m_frontValid.load(std::memory_order_relaxed)) {
+      return handle_t();
+    }
+    // the spare slot becomes the (empty) front slot
+    m_pinned = m_front;
+    m_front = m_spare;
+    m_spare = NO_SLOT;
+    m_frontValid.store(false, std::memory_order_relaxed);
+    return handle_t(this, m_pinned, m_storage.ptr(m_pinned));
+  }
+
+  // read the value without copying it, the handle is empty if there is no
+  // value (or another handle exists)
+  handle_t read_handle() {
+    if (m_pinned != NO_SLOT) {
+      return handle_t();
+    }
+    refresh();
+    if (!m_frontValid.load(std::memory_order_relaxed)) {
+      return handle_t();
+    }
+    m_pinned = m_front;
+    return handle_t(this, m_pinned, m_storage.ptr(m_pinned));
+  }
+
+  std::optional<T> read() {
+    refresh();
+    if (!m_frontValid.load(std::memory_order_relaxed)) {
+      return std::nullopt;
+    }
+    return std::optional<T>(m_storage[m_front]);
+  }
+
+  bool read(T &out) {
+    refresh();
+    if (!m_frontValid.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    out = m_storage[m_front];
+    return true;
+  }
+
+  bool empty() {
+    // the consumer marks the front slot as valid before it exchanges the
+    // middle slot, i.e. if we see the exchange we also see the valid front
+    if (m_middle.load(std::memory_order_acquire) & FRESH) {
+      return false;
+    }
+    return !m_frontValid.load(std::memory_order_relaxed);
+  }
+
+private:
+  friend loan_t;
+  friend handle_t;
+
+  // consumer: exchange the front slot with the middle slot if the producer
+  // published a new value (only the consumer removes the FRESH mark)
+  void refresh() {
+    if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) {
+      return;
+    }
+
+    // a pinned front slot is still read by a handle, hand over the spare slot
+    // instead (the pinned slot becomes the spare slot when the handle is
+    // released)
+    index_t free = m_front;
+    if (m_front == m_pinned) {
+      free = m_spare;
+      m_spare = NO_SLOT;
+    }
+
+    m_frontValid.store(true, std::memory_order_relaxed);
+    // release: the producer may overwrite the slot we hand over
+    // acquire: we see the value in the slot we get
+    auto old = m_middle.exchange(free, std::memory_order_acq_rel);
+    m_front = old & ~FRESH;
+  }
+
+  // return an unpublished loaned slot (the value is already destroyed)
+  void release(loan_t &) { m_loaned = false; }
+
+  // the handle releases the slot it pinned
+  void release(index_t index) {
+    m_pinned = NO_SLOT;
+    if (index != m_front) {
+      m_spare = index;
+    }
+  }
+};
+
+} // namespace lockfree
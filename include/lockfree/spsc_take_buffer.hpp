@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+
+#include "lockfree/layout.hpp"
+#include "lockfree/loan.hpp"
+#include "lockfree/read_handle.hpp"
+#include "lockfree/storage.hpp"
+
+namespace lockfree {
+
+// TakeBuffer for a single producer and a single consumer thread
+// (same interface, except that the capacity is fixed).
+//
+// Triple buffer like the SpscExchangeBuffer: the producer writes to its back
+// slot and exchanges it with the middle slot (marked as FRESH), the consumer
+// takes a FRESH middle slot by exchanging it with an empty slot of its own.
+// The consumer owns a spare slot for at most one take handle at a time.
+//
+// note: all producer operations (write, emplace, loan, publish, try_write)
+//       must be called by the same thread, the same holds for the consumer
+//       operations (take, take_handle) and the handles
+template <class T> class SpscTakeBuffer {
+private:
+  static constexpr uint32_t NUM_SLOTS = 4;
+
+  using storage_t = Storage<T, NUM_SLOTS>;
+  using index_t = uint32_t;
+
+  static constexpr index_t NO_SLOT = NUM_SLOTS;
+  static constexpr index_t FRESH = 1U << 31;
+
+  // producer
+  alignas(CACHE_LINE_SIZE) index_t m_back{0};
+  bool m_loaned{false};
+
+  // shared, only FRESH slots contain a value
+  alignas(CACHE_LINE_SIZE) std::atomic<index_t> m_middle{1};
+
+  // consumer (both slots are empty)
+  alignas(CACHE_LINE_SIZE) index_t m_front{2};
+  index_t m_spare{3};
+
+  storage_t m_storage;
+
+public:
+  using loan_t = Loan<T, SpscTakeBuffer>;
+  using handle_t = ReadHandle<T, SpscTakeBuffer>;
+
+  SpscTakeBuffer() = default;
+
+  SpscTakeBuffer(const SpscTakeBuffer &) = delete;
+  SpscTakeBuffer &operator=(const SpscTakeBuffer &) = delete;
+
+  ~SpscTakeBuffer() {
+    auto middle = m_middle.load(std::memory_order_acquire);
+    if (middle & FRESH) {
+      m_storage.free(middle & ~FRESH);
+    }
+  }
+
+  bool write(const T &value) { return emplace(value); }
+
+  // construct the value in place and publish it (like write)
+  template <class... Args> bool emplace(Args &&...args) {
+    auto slot = loan();
+    if (!slot) {
+      return false; // back slot is loaned
+    }
+    slot.emplace(std::forward<Args>(args)...);
+    return publish(std::move(slot));
+  }
+
+  // obtain the back slot to construct a value in place,
+  // the loan is invalid if the back slot is already loaned
+  loan_t loan() {
+    if (m_loaned) {
+      return loan_t();
+    }
+    m_loaned = true;
+    return loan_t(this, m_back, m_storage.ptr(m_back));
+  }
+
+  // publish the value constructed in a loaned slot (like write)
+  // fails if the loan holds no value (or belongs to another buffer)
+  bool publish(loan_t &&loan) {
+    if (!loan.has_value() || loan.m_owner != this) {
+      return false;
+    }
+    loan.m_owner = nullptr;
+    m_loaned = false;
+
+    // release: the consumer sees the value
+    // acquire: the consumer is done with the slot we get back
+    auto old = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+    m_back = old & ~FRESH;
+    if (old & FRESH) {
+      m_storage.free(m_back); // overwritten before it was taken
+    }
+    return true;
+  }
+
+  // only the producer adds values, i.e. the buffer stays empty until we write
+  bool try_write(const T &value) {
+    if (m_middle.load(std::memory_order_acquire) & FRESH) {
+      return false;
+    }
+    return write(value);
+  }
+
+  std::optional<T> take() {
+    auto index = exchange_front();
+    if (index == NO_SLOT) {
+      return std::nullopt;
+    }
+    auto ret = std::optional<T>(std::move(m_storage[index]));
+    m_storage.free(index);
+    m_front = index;
+    return ret;
+  }
+
+  bool take(T &out) {
+    auto index = exchange_front();
+    if (index == NO_SLOT) {
+      return false;
+    }
+    out = std::move(m_storage[index]);
+    m_storage.free(index);
+    m_front = index;
+    return true;
+  }
+
+  // take the value without copying it out of the buffer,
+  // the slot is freed when the handle is released
+  // the handle is empty if there is no value (or another handle exists)
+  handle_t take_handle() {
+    if (m_spare == NO_SLOT) {
+      return handle_t();
+    }
+    auto index = exchange_front();
+    if (index == NO_SLOT) {
+      return handle_t();
+    }
+    // the spare slot becomes the (empty) front slot
+    m_front = m_spare;
+    m_spare = NO_SLOT;
+    return handle_t(this, index, m_storage.ptr(index));
+  }
+
+  bool empty() {
+    return !(m_middle.load(std::memory_order_relaxed) & FRESH);
+  }
+
+private:
+  friend loan_t;
+  friend handle_t;
+
+  // consumer: exchange the front slot with a FRESH middle slot and return the
+  // index of the slot with the value (or NO_SLOT)
+  // the front slot is handed over to the producer afterwards
+  index_t exchange_front() {
+    if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) {
+      return NO_SLOT;
+    }
+    // release: the producer may overwrite the slot we hand over
+    // acquire: we see the value in the slot we get
+    auto old = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = NO_SLOT;
+    return old & ~FRESH;
+  }
+
+  // return an unpublished loaned slot (the value is already destroyed)
+  void release(loan_t &) { m_loaned = false; }
+
+  // the handle releases the slot it took
+  void release(index_t index) {
+    m_storage.free(index);
+    m_spare = index;
+  }
+};
+
+} // namespace lockfree
@@ -3,12 +3,17 @@
 #include <optional>
 #include <type_traits>
 
+#include "lockfree/layout.hpp"
+
 namespace lockfree {
 // assume we have this and the index pool abstraction
-template <typename T, uint32_t N, typename IndexType = uint32_t> class Storage {
+template <typename T, uint32_t N, typename IndexType = uint32_t,
+          typename Layout = PackedLayout>
+class Storage {
 private:
   using index_t = IndexType;
-  using slot_t = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+  using slot_t = typename Layout::template slot<
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type>;
   slot_t m_slots[N];
 
 public:
@@ -16,7 +21,9 @@ public:
 
   void free(index_t index) { ptr(index)->~T(); }
 
-  T *ptr(index_t index) { return reinterpret_cast<T *>(&m_slots[index]); }
+  T *ptr(index_t index) {
+    return reinterpret_cast<T *>(&m_slots[index].value);
+  }
 
   T &operator[](index_t index) { return *ptr(index); }
 };
@@ -2,20 +2,22 @@
 
 #include <assert.h>
 #include <atomic>
-#include <chrono>
-#include <thread>
+
+#include "lockfree/atomic.hpp"
+#include "lockfree/backoff.hpp"
+#include "lockfree/layout.hpp"
 
 namespace lockfree {
 
 // TODO: document and explain, restructure (.cpp etc.)
 class SyncCounter {
-  static constexpr int N = 1024;
-
 public:
   SyncCounter();
 
-  // trigger increment of both counters
-  void increment();
+  // trigger increment of both counters, Backoff is applied after a failed
+  // increment (instantiated for the policies of backoff.hpp with default
+  // parameters)
+  template <class Backoff = NoBackoff> void increment();
 
   // unsynced increment without trying to equalize counters
   void unsynced_increment();
@@ -27,17 +29,12 @@ public:
   std::pair<uint64_t, uint64_t> get_if_equal();
 
 private:
-  using counter_t = std::atomic<uint64_t>;
-  // separation of counters by dummy memory
-  // to have both counters in different cachelines
-  counter_t m_counters[4096];
-
-  counter_t &m_count1;
-  counter_t &m_count2;
+  using counter_t = atomic<uint64_t>;
+  // both counters in different cachelines
+  alignas(CACHE_LINE_SIZE) counter_t m_count1{0};
+  alignas(CACHE_LINE_SIZE) counter_t m_count2{0};
 
   void try_help(uint64_t &count1, uint64_t &count2);
-
-  void sleep(int ms = 1);
 };
 
 } // namespace lockfree
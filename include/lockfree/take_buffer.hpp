@@ -4,35 +4,70 @@
 #include <optional>
 #include <type_traits>
 
+#include "lockfree/atomic.hpp"
 #include "lockfree/index_pool.hpp"
+#include "lockfree/loan.hpp"
+#include "lockfree/read_handle.hpp"
 #include "lockfree/storage.hpp"
 
 namespace lockfree {
 
-template <class T, uint32_t C = 8> class TakeBuffer {
+template <class T, uint32_t C = 8, class IndexPoolType = IndexPool<C>>
+class TakeBuffer {
 private:
   using storage_t = Storage<T, C>;
-  using indexpool_t = IndexPool<C>;
+  using indexpool_t = IndexPoolType;
 
   using index_t = typename indexpool_t::index_t;
 
   static constexpr index_t NO_DATA = C;
 
-  std::atomic<index_t> m_index{NO_DATA};
+  static_assert(indexpool_t::CAPACITY == C);
+
+  atomic<index_t> m_index{NO_DATA};
   indexpool_t m_indices;
   storage_t m_storage;
 
 public:
-  bool write(const T &value) {
+  using loan_t = Loan<T, TakeBuffer>;
+  using handle_t = ReadHandle<T, TakeBuffer>;
+
+  bool write(const T &value) { return emplace(value); }
+
+  // construct the value in place and publish it (like write)
+  template <class... Args> bool emplace(Args &&...args) {
+    auto slot = loan();
+    if (!slot) {
+      return false; // no index
+    }
+    slot.emplace(std::forward<Args>(args)...);
+    return publish(std::move(slot));
+  }
+
+  // obtain an uninitialized slot to construct a value in place,
+  // the loan is invalid if there is no free slot
+  loan_t loan() {
     auto maybeIndex = m_indices.get();
     if (!maybeIndex) {
-      return false; // no index
+      return loan_t(); // no index
     }
     auto index = maybeIndex.value();
-    // will succeed since we the exclusive ownership of index
-    m_storage.store_at(value, index);
+    return loan_t(this, index, m_storage.ptr(index));
+  }
 
-    auto oldIndex = m_index.exchange(index);
+  // publish the value constructed in a loaned slot (like write)
+  // fails if the loan holds no value (or belongs to another buffer)
+  bool publish(loan_t &&loan) {
+    if (!loan.has_value() || loan.m_owner != this) {
+      return false;
+    }
+    // the buffer takes over ownership of the slot
+    auto index = loan.m_index;
+    loan.m_owner = nullptr;
+
+    // release: publish the value
+    // acquire: the value we replace is completely written before we free it
+    auto oldIndex = m_index.exchange(index, std::memory_order_acq_rel);
     if (oldIndex != NO_DATA) {
       free(oldIndex);
     }
@@ -48,7 +83,9 @@ public:
     m_storage.store_at(value, index);
 
     index_t expected = NO_DATA;
-    if (!m_index.compare_exchange_strong(expected, index)) {
+    if (!m_index.compare_exchange_strong(expected, index,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
       free(index);
       return false;
     }
@@ -56,7 +93,8 @@ public:
   }
 
   std::optional<T> take() {
-    auto index = m_index.exchange(NO_DATA);
+    // acquire: we see the value written before it was published
+    auto index = m_index.exchange(NO_DATA, std::memory_order_acquire);
     if (index == NO_DATA) {
       return std::nullopt;
     }
@@ -65,11 +103,48 @@ public:
     return ret;
   }
 
+  // take the value into out (move assigned, i.e. out can be reused),
+  // returns false and leaves out unchanged if there is no value
+  bool take(T &out) {
+    // acquire: we see the value written before it was published
+    auto index = m_index.exchange(NO_DATA, std::memory_order_acquire);
+    if (index == NO_DATA) {
+      return false;
+    }
+    out = std::move(m_storage[index]);
+    free(index);
+    return true;
+  }
+
+  // take the value without copying it out of the buffer,
+  // the slot is freed when the handle is released
+  // the handle is empty if there is no value
+  handle_t take_handle() {
+    auto index = m_index.exchange(NO_DATA, std::memory_order_acquire);
+    if (index == NO_DATA) {
+      return handle_t();
+    }
+    return handle_t(this, index, m_storage.ptr(index));
+  }
+
+  bool empty() {
+    return m_index.load(std::memory_order_relaxed) == NO_DATA;
+  }
+
 private:
+  friend loan_t;
+  friend handle_t;
+
   void free(index_t index) {
     m_storage.free(index);
     m_indices.free(index);
   }
+
+  // return an unpublished loaned slot (the value is already destroyed)
+  void release(loan_t &loan) { m_indices.free(loan.m_index); }
+
+  // the handle releases the slot it took
+  void release(index_t index) { free(index); }
 };
 
 } // namespace lockfree
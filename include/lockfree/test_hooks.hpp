@@ -0,0 +1,41 @@
+#pragma once
+
+// Interleaving points at which tests can inject delays (or other actions),
+// e.g. to leave an operation incomplete such that other threads have to help.
+//
+// The points are compiled out unless LOCKFREE_TEST_HOOKS is defined (for the
+// translation units of the data structure and the test alike), i.e. the
+// production build does not pay for them.
+
+#ifdef LOCKFREE_TEST_HOOKS
+#include <atomic>
+
+namespace lockfree::test_hooks {
+
+enum class Point {
+  // SyncCounter: m_count1 is incremented but m_count2 is not yet
+  SyncCounterBetweenIncrements,
+  // SyncCounter: an incomplete increment was detected and will be helped
+  SyncCounterBeforeHelp,
+};
+
+using hook_t = void (*)(Point);
+
+// called at every interleaving point (by all threads)
+inline std::atomic<hook_t> hook{nullptr};
+
+inline void at(Point point) {
+  if (auto h = hook.load(std::memory_order_acquire)) {
+    h(point);
+  }
+}
+
+} // namespace lockfree::test_hooks
+
+#define LOCKFREE_TEST_HOOK(point)                                              \
+  ::lockfree::test_hooks::at(::lockfree::test_hooks::Point::point)
+#else
+#define LOCKFREE_TEST_HOOK(point)                                              \
+  do {                                                                         \
+  } while (0)
+#endif
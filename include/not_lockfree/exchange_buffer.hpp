@@ -9,18 +9,23 @@
 
 namespace not_lockfree {
 
-// NB: not lock-free due to std::optional using dynamic memory
-// a static memory optional can be found e.g. in
-// https://github.com/eclipse-iceoryx/iceoryx/blob/master/iceoryx_hoofs/include/iceoryx_hoofs/cxx/optional.hpp
-template <class T, uint32_t C = 8> class ExchangeBuffer {
+// NB: naive version, read is not safe: the slot may be freed and reused
+// while it is copied and the CAS of the index does not detect this (ABA),
+// cf. lockfree::ExchangeBuffer (tagged index and validated read)
+// (std::optional stores the value in place and uses no dynamic memory)
+template <class T, uint32_t C = 8,
+          class IndexPoolType = lockfree::IndexPool<C>>
+class ExchangeBuffer {
 private:
   using storage_t = lockfree::Storage<T, C>;
-  using indexpool_t = lockfree::IndexPool<C>;
+  using indexpool_t = IndexPoolType;
 
   using index_t = typename indexpool_t::index_t;
 
   static constexpr index_t NO_DATA = C;
 
+  static_assert(indexpool_t::CAPACITY == C);
+
   std::atomic<index_t> m_index{NO_DATA};
   indexpool_t m_indices;
   storage_t m_storage;
@@ -5,6 +5,8 @@
 
 namespace not_lockfree {
 
+// NB: not lock-free since each write allocates with new (and take deletes),
+// cf. lockfree::TakeBuffer (slots of a Storage)
 template <class T> class TakeBuffer {
 private:
   std::atomic<T *> m_value{nullptr};
@@ -1,21 +1,25 @@
 #include "lockfree/sync_counter.hpp"
+#include "lockfree/test_hooks.hpp"
 
 namespace lockfree {
 
-SyncCounter::SyncCounter()
-    : m_count1(m_counters[0]), m_count2(m_counters[N - 1]) {
-  m_count1 = 0;
-  m_count2 = 0;
-}
+// memory order: the counters do not publish other data, but m_count2 is only
+// incremented after m_count1 was incremented, i.e. the counters are loaded
+// with acquire and updated with acq_rel to preserve this order for observers
+// (no seq_cst is required since we never rely on a total order of operations
+// on both counters)
 
-void SyncCounter::increment() {
-  uint64_t count1 = m_count1.load();
-  uint64_t count2 = m_count2.load();
+SyncCounter::SyncCounter() = default;
+
+template <class Backoff> void SyncCounter::increment() {
+  Backoff backoff;
+  uint64_t count1 = m_count1.load(std::memory_order_acquire);
+  uint64_t count2 = m_count2.load(std::memory_order_acquire);
 
   while (true) {
     // load state in 2 loads
-    count1 = m_count1.load();
-    count2 = m_count2.load();
+    count1 = m_count1.load(std::memory_order_acquire);
+    count2 = m_count2.load(std::memory_order_acquire);
     // they may be different if we look right during another operation
 
     // determine whether there may be an incomplete operation
@@ -35,7 +39,10 @@ void SyncCounter::increment() {
     // next CAS fails) unless someone changes them concurrently both equal
     // count1
 
-    if (m_count1.compare_exchange_strong(count1, count1 + 1)) {
+    // (a spurious failure of the weak CAS just retries)
+    if (m_count1.compare_exchange_weak(count1, count1 + 1,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
       // we incremented m_count1
       // our own operation is partially complete (count 1 incremented),
       // we will not try helping again but someone may help us
@@ -45,19 +52,26 @@ void SyncCounter::increment() {
 
     // we failed, someone else incremented m_count1 and potentially m_count2
     // concurrently, retry
+    backoff.backoff();
   };
 
-  // could add some sleep here to provoke incomplete operations with high
-  // probability
+  // tests may delay us here to provoke incomplete operations
+  LOCKFREE_TEST_HOOK(SyncCounterBetweenIncrements);
 
   // finalize operation by incrementing second count
   // may fail, but only if someone else concurrently helps us and completes the
   // operation for us
-  m_count2.compare_exchange_strong(count2, count1 + 1);
+  m_count2.compare_exchange_strong(count2, count1 + 1,
+                                   std::memory_order_acq_rel,
+                                   std::memory_order_relaxed);
 
   // we do not care for the result of CAS (either it worked because we
   // incremented or someone else did it for us and then we do not need to retry)
 }
+template void SyncCounter::increment<NoBackoff>();
+template void SyncCounter::increment<ExponentialBackoff<>>();
+template void SyncCounter::increment<SpinThenYieldBackoff<>>();
+
 #if 0
 // uncommented version
 void SyncCounter::increment() {
@@ -76,20 +90,20 @@ void SyncCounter::increment() {
     }
   } while (true);
 
-  sleep();
+  LOCKFREE_TEST_HOOK(SyncCounterBetweenIncrements);
   m_count2.compare_exchange_strong(count2, count1 + 1);
 }
 #endif
 
 void SyncCounter::unsynced_increment() {
-  ++m_count1;
-  sleep();
-  ++m_count2;
+  m_count1.fetch_add(1, std::memory_order_acq_rel);
+  LOCKFREE_TEST_HOOK(SyncCounterBetweenIncrements);
+  m_count2.fetch_add(1, std::memory_order_acq_rel);
 }
 
 uint64_t SyncCounter::sync() {
-  uint64_t count1 = m_count1.load();
-  uint64_t count2 = m_count2.load();
+  uint64_t count1 = m_count1.load(std::memory_order_acquire);
+  uint64_t count2 = m_count2.load(std::memory_order_acquire);
   while (count1 != count2) {
     try_help(count1, count2);
   }
@@ -99,11 +113,14 @@ uint64_t SyncCounter::sync() {
 }
 
 std::pair<uint64_t, uint64_t> SyncCounter::get_if_equal() {
-  uint64_t count1 = m_count1.load();
+  uint64_t count1 = m_count1.load(std::memory_order_acquire);
   uint64_t count2;
   do {
-    count2 = m_count2.load();
-  } while (!m_count1.compare_exchange_strong(count1, count1));
+    count2 = m_count2.load(std::memory_order_acquire);
+    // validates that count1 did not change (it is not modified)
+  } while (!m_count1.compare_exchange_weak(count1, count1,
+                                           std::memory_order_acquire,
+                                           std::memory_order_acquire));
   return {count1, count2};
 }
 
@@ -111,23 +128,24 @@ void SyncCounter::try_help(uint64_t &count1, uint64_t &count2) {
   if (count1 < count2) {
     // we are completely outdated, reload at least count1
 
-    count1 = m_count1.load();
-    count2 = m_count2.load();
+    count1 = m_count1.load(std::memory_order_acquire);
+    count2 = m_count2.load(std::memory_order_acquire);
     return;
   }
 
-  if (m_count2.compare_exchange_strong(count1, count1)) {
+  // count1 == count2 + 1, i.e. the increment of m_count2 is pending
+  LOCKFREE_TEST_HOOK(SyncCounterBeforeHelp);
+  if (m_count2.compare_exchange_strong(count2, count1,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
     // we completed the operation, and can try our own increment again
     count2 = count1;
   } else {
     // we failed so either the original operation completed on its own or
     // someone helped completing it (so we do not try again for this count)
-    count1 = m_count1.load();
+    // count2 holds the current value now
+    count1 = m_count1.load(std::memory_order_acquire);
   }
 }
 
-void SyncCounter::sleep(int ms) {
-  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
-}
-
 } // namespace lockfree
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/batch.hpp"
+#include "lockfree/exchange_buffer.hpp"
+#include "lockfree/spsc_take_buffer.hpp"
+#include "lockfree/take_buffer.hpp"
+
+#include <array>
+#include <forward_list>
+#include <vector>
+
+namespace {
+
+using IntBuffer = lockfree::ExchangeBuffer<int>;
+
+TEST(TestBatch, write_batch_publishes_last_value) {
+  IntBuffer buffer;
+  std::vector<int> values{1, 2, 3};
+  EXPECT_TRUE(lockfree::write_batch(buffer, values.begin(), values.end()));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 3);
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(TestBatch, write_batch_with_forward_iterators) {
+  lockfree::TakeBuffer<int> buffer;
+  std::forward_list<int> values{1, 2, 3};
+  EXPECT_TRUE(lockfree::write_batch(buffer, values.begin(), values.end()));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 3);
+}
+
+TEST(TestBatch, write_batch_of_empty_range_does_not_write) {
+  IntBuffer buffer;
+  std::vector<int> values;
+  EXPECT_FALSE(lockfree::write_batch(buffer, values.begin(), values.end()));
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(TestBatch, take_all_takes_values_of_all_buffers) {
+  std::array<IntBuffer, 100> buffers;
+  for (int i = 0; i < 100; i += 3) {
+    EXPECT_TRUE(buffers[i].write(i));
+  }
+
+  std::vector<int> taken(100, -1);
+  auto n = lockfree::take_all(buffers,
+                              [&](size_t i, int value) { taken[i] = value; });
+  EXPECT_EQ(n, 34U);
+
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(taken[i], i % 3 == 0 ? i : -1);
+    EXPECT_TRUE(buffers[i].empty());
+  }
+
+  // all buffers are empty now
+  n = lockfree::take_all(buffers, [&](size_t, int) { FAIL(); });
+  EXPECT_EQ(n, 0U);
+}
+
+TEST(TestBatch, take_all_of_buffer_pointers) {
+  lockfree::TakeBuffer<int> buffer1;
+  lockfree::SpscTakeBuffer<int> buffer2;
+  lockfree::TakeBuffer<int> buffer3;
+  EXPECT_TRUE(buffer1.write(1));
+  EXPECT_TRUE(buffer3.write(3));
+
+  std::vector<lockfree::TakeBuffer<int> *> buffers{&buffer1, &buffer3};
+  int sum = 0;
+  auto n =
+      lockfree::take_all(buffers, [&](size_t, int value) { sum += value; });
+  EXPECT_EQ(n, 2U);
+  EXPECT_EQ(sum, 4);
+
+  std::array<lockfree::SpscTakeBuffer<int> *, 1> spscBuffers{&buffer2};
+  EXPECT_EQ(lockfree::take_all(spscBuffers, [](size_t, int) {}), 0U);
+}
+
+} // namespace
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/cached_index_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Threads acquire and release indices concurrently and mark each index they
+// hold. An index that is already marked by someone else was handed out twice.
+// The threads exit at the end of each round, which drains their magazines.
+// After all rounds every index must be obtainable again, otherwise indices
+// were leaked.
+
+constexpr int NUM_THREADS = 8;
+constexpr int NUM_ROUNDS = 4;
+constexpr uint32_t MAGAZINE_SIZE = 4;
+constexpr uint32_t MAX_HELD = 4;
+constexpr uint32_t POOL_SIZE = NUM_THREADS * (MAGAZINE_SIZE + MAX_HELD);
+
+constexpr std::chrono::milliseconds runtime(500);
+
+using Pool = lockfree::CachedIndexPool<
+    POOL_SIZE, lockfree::FreeListIndexPool<POOL_SIZE>, MAGAZINE_SIZE>;
+using index_t = Pool::index_t;
+
+struct Marks {
+  std::atomic<int> marks[POOL_SIZE];
+  std::atomic<uint64_t> doubleHandouts{0};
+  std::atomic<uint64_t> failedGets{0};
+
+  Marks() {
+    for (auto &mark : marks) {
+      mark = 0;
+    }
+  }
+};
+
+void acquire_release(Pool &pool, Marks &marks, std::atomic<bool> &run,
+                     int id, uint64_t &numGets) {
+  numGets = 0;
+  index_t held[MAX_HELD];
+  // vary the number of indices held to have both refills and flushes
+  uint32_t numToHold = 1 + id % MAX_HELD;
+
+  while (run) {
+    uint32_t numHeld = 0;
+    for (; numHeld < numToHold; ++numHeld) {
+      auto index = pool.get();
+      if (!index) {
+        ++marks.failedGets;
+        break;
+      }
+      if (marks.marks[*index].exchange(1) != 0) {
+        ++marks.doubleHandouts;
+      }
+      held[numHeld] = *index;
+      ++numGets;
+    }
+
+    while (numHeld > 0) {
+      auto index = held[--numHeld];
+      marks.marks[index].store(0);
+      pool.free(index);
+    }
+
+    numToHold = numToHold % MAX_HELD + 1;
+  }
+}
+
+TEST(CachedIndexPoolStressTest, no_index_is_leaked_or_handed_out_twice) {
+  Pool pool;
+  Marks marks;
+  std::vector<uint64_t> gets(NUM_THREADS, 0);
+
+  for (int round = 0; round < NUM_ROUNDS; ++round) {
+    std::vector<std::thread> threads;
+    threads.reserve(NUM_THREADS);
+    std::atomic<bool> run{true};
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+      threads.emplace_back(&acquire_release, std::ref(pool), std::ref(marks),
+                           std::ref(run), i + round, std::ref(gets[i]));
+    }
+
+    std::this_thread::sleep_for(runtime);
+    run = false;
+
+    // exiting threads return their cached indices
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    for (auto numGets : gets) {
+      std::cout << numGets << std::endl;
+    }
+  }
+
+  EXPECT_EQ(marks.doubleHandouts.load(), 0);
+  // the pool is large enough to serve all threads
+  EXPECT_EQ(marks.failedGets.load(), 0);
+
+  // all indices are available again
+  std::set<index_t> indices;
+  for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+    auto index = pool.get();
+    ASSERT_TRUE(index.has_value());
+    indices.insert(*index);
+  }
+  EXPECT_EQ(indices.size(), POOL_SIZE);
+  EXPECT_FALSE(pool.get().has_value());
+}
+
+} // namespace
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/backoff.hpp"
+#include "lockfree/cas_loop.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(TestCasLoop, compare_exchange_if_not_equal) {
+  std::atomic<int> value{1};
+  EXPECT_FALSE(lockfree::compare_exchange_if_not_equal(value, 1, 2));
+  EXPECT_EQ(value.load(), 1);
+  EXPECT_TRUE(
+      lockfree::compare_exchange_if_not_equal<lockfree::ExponentialBackoff<>>(
+          value, 3, 2));
+  EXPECT_EQ(value.load(), 2);
+}
+
+TEST(TestCasLoop, fetch_update_applies_function) {
+  std::atomic<int> value{3};
+  EXPECT_EQ(lockfree::fetch_update(value, [](int x) { return 2 * x + 1; }), 3);
+  EXPECT_EQ(value.load(), 7);
+}
+
+TEST(TestCasLoop, fetch_multiply) {
+  std::atomic<int> value{3};
+  EXPECT_EQ(lockfree::fetch_multiply(value, 4), 3);
+  EXPECT_EQ(value.load(), 12);
+  EXPECT_EQ(lockfree::fetch_multiply(value, 0), 12);
+  EXPECT_EQ(value.load(), 0);
+
+  std::atomic<double> real{1.5};
+  EXPECT_EQ(lockfree::fetch_multiply(real, 2), 1.5);
+  EXPECT_EQ(real.load(), 3.0);
+}
+
+TEST(TestCasLoop, fetch_multiply_floating_point_by_zero) {
+  std::atomic<double> value{std::numeric_limits<double>::infinity()};
+  lockfree::fetch_multiply(value, 0);
+  EXPECT_TRUE(std::isnan(value.load()));
+
+  value = std::numeric_limits<double>::quiet_NaN();
+  lockfree::fetch_multiply(value, 0);
+  EXPECT_TRUE(std::isnan(value.load()));
+
+  value = -3.0;
+  EXPECT_EQ(lockfree::fetch_multiply(value, 0), -3.0);
+  EXPECT_EQ(value.load(), 0.0);
+  EXPECT_TRUE(std::signbit(value.load()));
+}
+
+TEST(TestCasLoop, fetch_max_and_fetch_min) {
+  std::atomic<int> value{5};
+  EXPECT_EQ(lockfree::fetch_max(value, 3), 5);
+  EXPECT_EQ(value.load(), 5);
+  EXPECT_EQ(lockfree::fetch_max(value, 8), 5);
+  EXPECT_EQ(value.load(), 8);
+  EXPECT_EQ(lockfree::fetch_min(value, 9), 8);
+  EXPECT_EQ(value.load(), 8);
+  EXPECT_EQ(lockfree::fetch_min(value, -1), 8);
+  EXPECT_EQ(value.load(), -1);
+}
+
+TEST(TestCasLoop, fetch_saturating_add_clamps) {
+  std::atomic<uint8_t> value{250};
+  EXPECT_EQ(lockfree::fetch_saturating_add(value, 3), 250);
+  EXPECT_EQ(value.load(), 253);
+  EXPECT_EQ(lockfree::fetch_saturating_add(value, 10), 253);
+  EXPECT_EQ(value.load(), 255);
+  EXPECT_EQ(lockfree::fetch_saturating_add(value, 1), 255);
+  EXPECT_EQ(value.load(), 255);
+
+  std::atomic<int> signedValue{std::numeric_limits<int>::min() + 1};
+  lockfree::fetch_saturating_add(signedValue, -5);
+  EXPECT_EQ(signedValue.load(), std::numeric_limits<int>::min());
+  lockfree::fetch_saturating_add(signedValue, 7);
+  EXPECT_EQ(signedValue.load(), std::numeric_limits<int>::min() + 7);
+}
+
+TEST(TestCasLoop, fetch_add_floating_point) {
+  std::atomic<float> value{1.0f};
+  EXPECT_EQ(lockfree::fetch_add(value, 0.5f), 1.0f);
+  EXPECT_EQ(value.load(), 1.5f);
+}
+
+// concurrent updates with a backoff policy are not lost
+TEST(TestCasLoop, concurrent_updates) {
+  constexpr int NUM_THREADS = 4;
+  constexpr int NUM_UPDATES = 10000;
+  std::atomic<double> sum{0};
+  std::atomic<int> max{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([&, i] {
+      for (int j = 1; j <= NUM_UPDATES; ++j) {
+        lockfree::fetch_add<lockfree::SpinThenYieldBackoff<>>(sum, 1.0);
+        int value = j * NUM_THREADS + i;
+        lockfree::fetch_max<lockfree::ExponentialBackoff<>>(max, value);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // sums of integers are exact in double
+  EXPECT_EQ(sum.load(), double(NUM_THREADS * NUM_UPDATES));
+  EXPECT_EQ(max.load(), NUM_UPDATES * NUM_THREADS + NUM_THREADS - 1);
+}
+
+} // namespace
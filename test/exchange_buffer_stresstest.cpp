@@ -6,6 +6,7 @@
 #include <chrono>
 #include <iostream>
 #include <numeric>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -114,6 +115,65 @@ TEST(ExchangeBufferStressTest, using_try_write_and_take_we_lose_no_data) {
   EXPECT_EQ(expectedSum, sum);
 }
 
+void take_wait(Buffer &buffer, std::atomic<bool> &run, int id, uint64_t &sum) {
+  using namespace std::chrono_literals;
+  sum = 0;
+  while (run) {
+    // block instead of polling (the timeout allows to check run)
+    auto result = buffer.take_wait(10ms);
+    if (result.has_value()) {
+      sum += *result;
+    }
+  }
+}
+
+// Like above but with blocking readers: a wake-up that gets lost would
+// not lose data but the readers would only see it after their timeout,
+// i.e. only the sum is checked here.
+TEST(ExchangeBufferStressTest, using_try_write_and_take_wait_we_lose_no_data) {
+  Buffer buffer;
+  std::vector<uint64_t> maxs(NUM_WRITER_THREADS, 0);
+  std::vector<uint64_t> sums(NUM_READER_THREADS, 0);
+  std::vector<std::thread> writers;
+  std::vector<std::thread> readers;
+
+  std::atomic<bool> run{true};
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    readers.emplace_back(&take_wait, std::ref(buffer), std::ref(run), i,
+                         std::ref(sums[i]));
+  }
+
+  for (int i = 0; i < NUM_WRITER_THREADS; ++i) {
+    writers.emplace_back(&try_write, std::ref(buffer), std::ref(run), i,
+                         std::ref(maxs[i]));
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  uint64_t expectedSum = 0;
+  for (auto max : maxs) {
+    std::cout << max << std::endl;
+    expectedSum += gauss_sum(max);
+  }
+
+  auto sum = std::accumulate(sums.begin(), sums.end(), 0ULL);
+  auto value = buffer.take();
+  if (value) {
+    sum += *value;
+  }
+
+  EXPECT_EQ(expectedSum, sum);
+}
+
 void write1(Buffer &buffer, std::atomic<bool> &run, int id, uint64_t &max) {
   max = 0;
   while (run) {
@@ -298,4 +358,462 @@ TEST(ExchangeBufferStressTest,
   }
 }
 
-} // namespace
\ No newline at end of file
+// Payload consisting of several words which are all equal if the payload is
+// not corrupted (torn).
+struct Sample {
+  int id;
+  uint64_t words[8];
+
+  void set(uint64_t value) {
+    for (auto &word : words) {
+      word = value;
+    }
+  }
+
+  bool consistent() const {
+    for (auto word : words) {
+      if (word != words[0]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+using SampleBuffer = lockfree::ExchangeBuffer<Sample, NUM_THREADS + 1>;
+
+void write3(SampleBuffer &buffer, std::atomic<bool> &run, int id) {
+  Sample sample;
+  sample.id = id;
+  uint64_t value = 1;
+  while (run) {
+    sample.set(value);
+    if (buffer.write(sample)) {
+      ++value;
+    }
+  }
+}
+
+void take3(SampleBuffer &buffer, std::atomic<bool> &run, int &consistent,
+           uint64_t &numTaken) {
+  consistent = 1;
+  numTaken = 0;
+  while (run) {
+    auto result = buffer.take();
+    if (result.has_value()) {
+      ++numTaken;
+      if (!result->consistent()) {
+        consistent = 0;
+      }
+    }
+  }
+}
+
+void read3(SampleBuffer &buffer, std::atomic<bool> &run, int &consistent,
+           int &ordered, uint64_t &numRead) {
+  consistent = 1;
+  ordered = 1;
+  numRead = 0;
+  std::array<uint64_t, NUM_WRITER_THREADS> prevValue{0};
+  while (run) {
+    auto result = buffer.read();
+    if (result.has_value()) {
+      ++numRead;
+      if (!result->consistent()) {
+        consistent = 0;
+        continue;
+      }
+      auto value = result->words[0];
+      if (value < prevValue[result->id]) {
+        ordered = 0;
+      }
+      prevValue[result->id] = value;
+    }
+  }
+}
+
+// read only validates the copy with loads (no CAS), we check that readers
+// never observe a corrupted (concurrently overwritten) value while writers
+// write and a consumer concurrently takes values out of the buffer.
+TEST(ExchangeBufferStressTest,
+     concurrent_read_with_write_and_take_returns_consistent_data) {
+
+  SampleBuffer buffer;
+  constexpr int NUM_SAMPLE_WRITERS = NUM_WRITER_THREADS - 1;
+  std::vector<int> consistent(NUM_READER_THREADS, 1);
+  std::vector<int> ordered(NUM_READER_THREADS, 1);
+  std::vector<uint64_t> numRead(NUM_READER_THREADS, 0);
+  int takenConsistent = 1;
+  uint64_t numTaken = 0;
+  std::vector<std::thread> writers;
+  std::vector<std::thread> readers;
+  writers.reserve(NUM_SAMPLE_WRITERS);
+  readers.reserve(NUM_READER_THREADS);
+
+  std::atomic<bool> run{true};
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    readers.emplace_back(&read3, std::ref(buffer), std::ref(run),
+                         std::ref(consistent[i]), std::ref(ordered[i]),
+                         std::ref(numRead[i]));
+  }
+
+  std::thread taker(&take3, std::ref(buffer), std::ref(run),
+                    std::ref(takenConsistent), std::ref(numTaken));
+
+  for (int i = 0; i < NUM_SAMPLE_WRITERS; ++i) {
+    writers.emplace_back(&write3, std::ref(buffer), std::ref(run), i);
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  taker.join();
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  std::cout << "taken " << numTaken << std::endl;
+  EXPECT_EQ(takenConsistent, 1);
+
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    std::cout << "read " << numRead[i] << std::endl;
+    EXPECT_EQ(consistent[i], 1);
+    EXPECT_EQ(ordered[i], 1);
+  }
+}
+
+void take_handle4(SampleBuffer &buffer, std::atomic<bool> &run,
+                  int &consistent) {
+  consistent = 1;
+  bool useHandle = false;
+  while (run) {
+    // alternate between copying and zero-copy take
+    if (useHandle) {
+      auto handle = buffer.take_handle();
+      if (handle && !handle->consistent()) {
+        consistent = 0;
+      }
+    } else {
+      auto result = buffer.take();
+      if (result.has_value() && !result->consistent()) {
+        consistent = 0;
+      }
+    }
+    useHandle = !useHandle;
+  }
+}
+
+void read_handle4(SampleBuffer &buffer, std::atomic<bool> &run,
+                  int &unchanged, uint64_t &numRead) {
+  unchanged = 1;
+  numRead = 0;
+  while (run) {
+    auto handle = buffer.read_handle();
+    if (!handle) {
+      continue;
+    }
+    ++numRead;
+    // the pinned value must neither be corrupted nor change while we hold it
+    auto value = handle->words[0];
+    for (int i = 0; i < 10; ++i) {
+      if (!handle->consistent() || handle->words[0] != value) {
+        unchanged = 0;
+      }
+      std::this_thread::yield();
+    }
+  }
+}
+
+// read handles pin the slot, we check that the pinned value never changes
+// while writers write and a consumer concurrently takes values (also with
+// handles).
+TEST(ExchangeBufferStressTest,
+     read_handles_are_not_affected_by_concurrent_write_and_take) {
+
+  SampleBuffer buffer;
+  constexpr int NUM_SAMPLE_WRITERS = NUM_WRITER_THREADS - 1;
+  std::vector<int> unchanged(NUM_READER_THREADS, 1);
+  std::vector<uint64_t> numRead(NUM_READER_THREADS, 0);
+  int takenConsistent = 1;
+  std::vector<std::thread> writers;
+  std::vector<std::thread> readers;
+  writers.reserve(NUM_SAMPLE_WRITERS);
+  readers.reserve(NUM_READER_THREADS);
+
+  std::atomic<bool> run{true};
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    readers.emplace_back(&read_handle4, std::ref(buffer), std::ref(run),
+                         std::ref(unchanged[i]), std::ref(numRead[i]));
+  }
+
+  std::thread taker(&take_handle4, std::ref(buffer), std::ref(run),
+                    std::ref(takenConsistent));
+
+  for (int i = 0; i < NUM_SAMPLE_WRITERS; ++i) {
+    writers.emplace_back(&write3, std::ref(buffer), std::ref(run), i);
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  taker.join();
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(takenConsistent, 1);
+
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    std::cout << "read " << numRead[i] << std::endl;
+    EXPECT_EQ(unchanged[i], 1);
+  }
+
+  // all slots were released, i.e. we can loan all of them after taking the
+  // remaining value
+  buffer.take();
+  std::vector<SampleBuffer::loan_t> loans;
+  while (auto loan = buffer.loan()) {
+    loans.push_back(std::move(loan));
+  }
+  EXPECT_EQ(loans.size(), NUM_THREADS + 1);
+}
+
+using StringBuffer = lockfree::ExchangeBuffer<std::string, NUM_THREADS + 1>;
+
+// a string of one repeated character, long enough to be allocated on the heap
+std::string text(uint64_t value) { return std::string(64, 'a' + value % 26); }
+
+bool consistent(const std::string &s) {
+  return s.size() == 64 && s.find_first_not_of(s[0]) == std::string::npos;
+}
+
+void write_strings(StringBuffer &buffer, std::atomic<bool> &run) {
+  uint64_t value = 0;
+  while (run) {
+    buffer.write(text(value++));
+  }
+}
+
+void read_strings(StringBuffer &buffer, std::atomic<bool> &run,
+                  int &consistentRead, uint64_t &numRead) {
+  consistentRead = 1;
+  numRead = 0;
+  while (run) {
+    auto result = buffer.read();
+    if (result.has_value()) {
+      ++numRead;
+      if (!consistent(*result)) {
+        consistentRead = 0;
+      }
+    }
+    auto taken = buffer.take();
+    if (taken.has_value() && !consistent(*taken)) {
+      consistentRead = 0;
+    }
+  }
+}
+
+// values that are not trivially copyable (allocating strings) must not be
+// destroyed while a reader copies them, i.e. readers never see a corrupted
+// (or freed) string (run with ThreadSanitizer or AddressSanitizer)
+TEST(ExchangeBufferStressTest,
+     concurrent_read_of_non_trivially_copyable_values_is_safe) {
+
+  StringBuffer buffer;
+  std::vector<int> consistentRead(NUM_READER_THREADS, 1);
+  std::vector<uint64_t> numRead(NUM_READER_THREADS, 0);
+  std::vector<std::thread> writers;
+  std::vector<std::thread> readers;
+
+  std::atomic<bool> run{true};
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    readers.emplace_back(&read_strings, std::ref(buffer), std::ref(run),
+                         std::ref(consistentRead[i]), std::ref(numRead[i]));
+  }
+
+  for (int i = 0; i < NUM_WRITER_THREADS; ++i) {
+    writers.emplace_back(&write_strings, std::ref(buffer), std::ref(run));
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    std::cout << "read " << numRead[i] << std::endl;
+    EXPECT_EQ(consistentRead[i], 1);
+  }
+}
+
+void pin_strings(StringBuffer &buffer, std::atomic<bool> &run,
+                 int &consistentRead, uint64_t &numRead) {
+  consistentRead = 1;
+  numRead = 0;
+  bool useHandle = false;
+  while (run) {
+    // alternate between copying and holding a pinned string, take must not
+    // move (or destroy) it meanwhile
+    if (useHandle) {
+      auto handle = buffer.read_handle();
+      if (handle) {
+        ++numRead;
+        for (int i = 0; i < 4; ++i) {
+          if (!consistent(*handle)) {
+            consistentRead = 0;
+          }
+          std::this_thread::yield();
+        }
+      }
+    } else {
+      auto result = buffer.read();
+      if (result.has_value()) {
+        ++numRead;
+        if (!consistent(*result)) {
+          consistentRead = 0;
+        }
+      }
+    }
+    useHandle = !useHandle;
+  }
+}
+
+void take_strings(StringBuffer &buffer, std::atomic<bool> &run,
+                  int &consistentTake) {
+  consistentTake = 1;
+  while (run) {
+    auto taken = buffer.take();
+    if (taken.has_value() && !consistent(*taken)) {
+      consistentTake = 0;
+    }
+  }
+}
+
+// readers pin the slot of a string (read and read_handle) while other threads
+// take the strings, i.e. take has to see the pin and copy instead of moving
+// the string (cf. the seq_cst handshake of read_handle and take_with)
+// note: x86 does not reorder the handshake (store-load), the reordering only
+//       occurs on weakly ordered targets (e.g. ARM), where a string moved or
+//       freed under a reader is reported by ThreadSanitizer or
+//       AddressSanitizer (-DLOCKFREE_TSAN=ON)
+TEST(ExchangeBufferStressTest,
+     take_does_not_move_strings_pinned_by_readers) {
+
+  StringBuffer buffer;
+  constexpr int NUM_TAKERS = NUM_WRITER_THREADS / 2;
+  std::vector<int> consistentRead(NUM_READER_THREADS, 1);
+  std::vector<uint64_t> numRead(NUM_READER_THREADS, 0);
+  std::vector<int> consistentTake(NUM_TAKERS, 1);
+  std::vector<std::thread> threads;
+
+  std::atomic<bool> run{true};
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    threads.emplace_back(&pin_strings, std::ref(buffer), std::ref(run),
+                         std::ref(consistentRead[i]), std::ref(numRead[i]));
+  }
+  for (int i = 0; i < NUM_TAKERS; ++i) {
+    threads.emplace_back(&take_strings, std::ref(buffer), std::ref(run),
+                         std::ref(consistentTake[i]));
+  }
+  for (int i = 0; i < NUM_WRITER_THREADS - NUM_TAKERS; ++i) {
+    threads.emplace_back(&write_strings, std::ref(buffer), std::ref(run));
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    std::cout << "read " << numRead[i] << std::endl;
+    EXPECT_EQ(consistentRead[i], 1);
+  }
+  for (int i = 0; i < NUM_TAKERS; ++i) {
+    EXPECT_EQ(consistentTake[i], 1);
+  }
+}
+
+void read_into(SampleBuffer &buffer, std::atomic<bool> &run, int &consistent,
+               uint64_t &numRead) {
+  consistent = 1;
+  numRead = 0;
+  Sample out;
+  out.set(0);
+  while (run) {
+    // out is only assigned validated copies, also if the buffer was empty
+    if (buffer.read(out)) {
+      ++numRead;
+    }
+    if (!out.consistent()) {
+      consistent = 0;
+    }
+  }
+}
+
+// read(out) reuses the object of the reader, which must never hold a
+// corrupted copy (whether a value was read or not) while writers write and a
+// consumer concurrently takes values out of the buffer.
+TEST(ExchangeBufferStressTest,
+     concurrent_read_into_existing_object_never_leaves_corrupted_data) {
+
+  SampleBuffer buffer;
+  constexpr int NUM_SAMPLE_WRITERS = NUM_WRITER_THREADS - 1;
+  std::vector<int> consistent(NUM_READER_THREADS, 1);
+  std::vector<uint64_t> numRead(NUM_READER_THREADS, 0);
+  int takenConsistent = 1;
+  uint64_t numTaken = 0;
+  std::vector<std::thread> writers;
+  std::vector<std::thread> readers;
+
+  std::atomic<bool> run{true};
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    readers.emplace_back(&read_into, std::ref(buffer), std::ref(run),
+                         std::ref(consistent[i]), std::ref(numRead[i]));
+  }
+
+  std::thread taker(&take3, std::ref(buffer), std::ref(run),
+                    std::ref(takenConsistent), std::ref(numTaken));
+
+  for (int i = 0; i < NUM_SAMPLE_WRITERS; ++i) {
+    writers.emplace_back(&write3, std::ref(buffer), std::ref(run), i);
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  taker.join();
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(takenConsistent, 1);
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    std::cout << "read " << numRead[i] << std::endl;
+    EXPECT_EQ(consistent[i], 1);
+  }
+}
+
+} // namespace
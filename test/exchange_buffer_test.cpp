@@ -2,10 +2,15 @@
 
 #include "lockfree/exchange_buffer.hpp"
 
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace {
 
 // only test the lock-free implementation of ExchangeBuffer
-// TODO: typed tests for different types T (trivially copyable etc.)
 
 using IntBuffer = lockfree::ExchangeBuffer<int>;
 
@@ -95,4 +100,345 @@ TEST_F(TestExchangeBuffer, read_does_not_remove_value) {
   EXPECT_EQ(*result, 73);
 }
 
-} // namespace
\ No newline at end of file
+TEST_F(TestExchangeBuffer, emplace_constructs_value_in_buffer) {
+  EXPECT_TRUE(buffer.emplace(73));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+}
+
+TEST_F(TestExchangeBuffer, published_loan_is_written_to_buffer) {
+  auto loan = buffer.loan();
+  ASSERT_TRUE(loan);
+  EXPECT_FALSE(loan.has_value());
+  loan.emplace(37);
+  EXPECT_TRUE(loan.has_value());
+  *loan += 36;
+  EXPECT_TRUE(buffer.empty());
+
+  EXPECT_TRUE(buffer.publish(std::move(loan)));
+  EXPECT_FALSE(loan);
+  auto result = buffer.read();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+}
+
+TEST_F(TestExchangeBuffer, loan_without_value_cannot_be_published) {
+  auto loan = buffer.loan();
+  ASSERT_TRUE(loan);
+  EXPECT_FALSE(buffer.publish(std::move(loan)));
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST_F(TestExchangeBuffer, loan_of_other_buffer_cannot_be_published) {
+  IntBuffer other;
+  auto loan = other.loan();
+  ASSERT_TRUE(loan);
+  loan.emplace(73);
+  EXPECT_FALSE(buffer.publish(std::move(loan)));
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_TRUE(other.publish(std::move(loan)));
+  EXPECT_FALSE(other.empty());
+}
+
+// With loans we can hold on to slots and hence exhaust the memory.
+TEST_F(TestExchangeBuffer, write_fails_if_all_slots_are_loaned) {
+  std::vector<IntBuffer::loan_t> loans;
+  while (auto loan = buffer.loan()) {
+    loans.push_back(std::move(loan));
+  }
+  EXPECT_FALSE(loans.empty());
+  EXPECT_FALSE(buffer.write(73));
+  EXPECT_FALSE(buffer.emplace(73));
+
+  // dropping an unpublished loan returns the slot
+  loans.pop_back();
+  EXPECT_TRUE(buffer.write(73));
+}
+
+TEST_F(TestExchangeBuffer, read_handle_is_empty_if_buffer_is_empty) {
+  auto handle = buffer.read_handle();
+  EXPECT_FALSE(handle.has_value());
+  EXPECT_FALSE(buffer.take_handle());
+}
+
+TEST_F(TestExchangeBuffer, read_handle_does_not_remove_value) {
+  EXPECT_TRUE(buffer.write(73));
+  auto handle = buffer.read_handle();
+  ASSERT_TRUE(handle.has_value());
+  EXPECT_EQ(*handle, 73);
+  EXPECT_FALSE(buffer.empty());
+  auto result = buffer.read();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+}
+
+TEST_F(TestExchangeBuffer, pinned_value_is_not_overwritten_by_writes) {
+  EXPECT_TRUE(buffer.write(73));
+  auto handle = buffer.read_handle();
+  ASSERT_TRUE(handle);
+
+  // more writes than slots, the pinned slot cannot be reused
+  for (int i = 0; i < 32; ++i) {
+    EXPECT_TRUE(buffer.write(i));
+  }
+  EXPECT_EQ(*handle, 73);
+
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 31);
+  EXPECT_EQ(*handle, 73);
+}
+
+TEST_F(TestExchangeBuffer, released_handles_free_their_slots) {
+  EXPECT_TRUE(buffer.write(73));
+  {
+    auto handle1 = buffer.read_handle();
+    auto handle2 = buffer.read_handle();
+    EXPECT_TRUE(buffer.write(37));
+    handle1.reset();
+    EXPECT_FALSE(handle1);
+    EXPECT_EQ(*handle2, 73);
+  }
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 37);
+
+  // all slots are free again
+  std::vector<IntBuffer::loan_t> loans;
+  while (auto loan = buffer.loan()) {
+    loans.push_back(std::move(loan));
+  }
+  EXPECT_EQ(loans.size(), 8);
+}
+
+TEST_F(TestExchangeBuffer, take_handle_removes_value) {
+  EXPECT_TRUE(buffer.write(73));
+  auto handle = buffer.take_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_EQ(*handle, 73);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_TRUE(buffer.write(37));
+  EXPECT_EQ(*handle, 73);
+}
+
+using namespace std::chrono_literals;
+
+TEST_F(TestExchangeBuffer, take_wait_returns_value_immediately) {
+  EXPECT_TRUE(buffer.write(73));
+  auto result = buffer.take_wait(1h);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST_F(TestExchangeBuffer, take_wait_times_out_if_empty) {
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(buffer.take_wait(20ms).has_value());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+  EXPECT_FALSE(buffer.read_wait(0ms).has_value());
+}
+
+TEST_F(TestExchangeBuffer, take_wait_is_woken_by_write) {
+  std::thread writer([&] {
+    std::this_thread::sleep_for(10ms);
+    buffer.write(73);
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  auto result = buffer.take_wait(1h);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 10s);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+  writer.join();
+}
+
+TEST_F(TestExchangeBuffer, read_wait_is_woken_by_try_write) {
+  std::thread writer([&] {
+    std::this_thread::sleep_for(10ms);
+    buffer.try_write(73);
+  });
+
+  auto result = buffer.read_wait(1h);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+  EXPECT_FALSE(buffer.empty());
+  writer.join();
+}
+
+TEST_F(TestExchangeBuffer, take_and_read_assign_to_existing_object) {
+  int out = 21;
+  EXPECT_FALSE(buffer.take(out));
+  EXPECT_FALSE(buffer.read(out));
+  EXPECT_EQ(out, 21);
+
+  EXPECT_TRUE(buffer.write(73));
+  EXPECT_TRUE(buffer.read(out));
+  EXPECT_EQ(out, 73);
+  EXPECT_TRUE(buffer.write(37));
+  EXPECT_TRUE(buffer.take(out));
+  EXPECT_EQ(out, 37);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_FALSE(buffer.take(out));
+  EXPECT_EQ(out, 37);
+}
+
+TEST_F(TestExchangeBuffer, take_wait_assigns_to_existing_object) {
+  int out = 0;
+  EXPECT_FALSE(buffer.take_wait(out, 0ms));
+  EXPECT_FALSE(buffer.read_wait(out, 0ms));
+
+  std::thread writer([&] {
+    std::this_thread::sleep_for(10ms);
+    buffer.write(73);
+  });
+  EXPECT_TRUE(buffer.read_wait(out, 1h));
+  EXPECT_EQ(out, 73);
+  EXPECT_TRUE(buffer.take_wait(out, 1h));
+  EXPECT_EQ(out, 73);
+  writer.join();
+}
+
+TEST(TestExchangeBufferBackoff, operations_with_backoff_policy) {
+  lockfree::ExchangeBuffer<int, 8, lockfree::IndexPool<8>,
+                           lockfree::SpinThenYieldBackoff<>>
+      buffer;
+  EXPECT_TRUE(buffer.write(73));
+  EXPECT_FALSE(buffer.try_write(37));
+  EXPECT_EQ(buffer.read().value_or(0), 73);
+  EXPECT_TRUE(buffer.write(37));
+  EXPECT_EQ(buffer.take().value_or(0), 37);
+  EXPECT_TRUE(buffer.empty());
+}
+
+// counts its live instances to detect leaked or twice destroyed values
+struct Counted {
+  static inline int instances = 0;
+
+  Counted(const std::string &text) : text(text) { ++instances; }
+  Counted(const Counted &other) : text(other.text) { ++instances; }
+  Counted(Counted &&other) : text(std::move(other.text)) { ++instances; }
+  ~Counted() { --instances; }
+
+  std::string text;
+};
+
+class TestExchangeBufferNonTrivial : public ::testing::Test {
+public:
+  void SetUp() override { Counted::instances = 0; }
+
+  void TearDown() override { EXPECT_EQ(Counted::instances, 0); }
+};
+
+TEST_F(TestExchangeBufferNonTrivial, read_and_take_copy_the_value) {
+  lockfree::ExchangeBuffer<std::string, 4> buffer;
+  std::string text(100, 'x');
+  EXPECT_TRUE(buffer.write(text));
+  EXPECT_EQ(buffer.read().value_or(""), text);
+  EXPECT_EQ(buffer.read().value_or(""), text);
+  EXPECT_EQ(buffer.take().value_or(""), text);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_FALSE(buffer.read().has_value());
+}
+
+TEST_F(TestExchangeBufferNonTrivial, overwritten_values_are_destroyed) {
+  {
+    lockfree::ExchangeBuffer<Counted, 4> buffer;
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_TRUE(buffer.write(Counted(std::to_string(i))));
+      EXPECT_EQ(Counted::instances, 1);
+    }
+    EXPECT_EQ(buffer.read()->text, "9");
+    EXPECT_EQ(Counted::instances, 1);
+  }
+  // the buffer destroys the value it holds
+  EXPECT_EQ(Counted::instances, 0);
+}
+
+TEST_F(TestExchangeBufferNonTrivial, pinned_value_is_destroyed_after_handle) {
+  lockfree::ExchangeBuffer<Counted, 4> buffer;
+  EXPECT_TRUE(buffer.write(Counted("first")));
+  auto handle = buffer.read_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_TRUE(buffer.write(Counted("second")));
+  EXPECT_EQ(Counted::instances, 2);
+  EXPECT_EQ(handle->text, "first");
+  handle.reset();
+  EXPECT_EQ(Counted::instances, 1);
+
+  // the value is copied (not moved) if it is still pinned
+  handle = buffer.read_handle();
+  auto taken = buffer.take();
+  ASSERT_TRUE(taken.has_value());
+  EXPECT_EQ(taken->text, "second");
+  EXPECT_EQ(handle->text, "second");
+  handle.reset();
+  taken.reset();
+}
+
+TEST_F(TestExchangeBufferNonTrivial, read_reuses_memory_of_destination) {
+  lockfree::ExchangeBuffer<std::string, 4> buffer;
+  std::string out;
+  out.reserve(200);
+  auto data = out.data();
+
+  std::string text(100, 'x');
+  EXPECT_TRUE(buffer.write(text));
+  EXPECT_TRUE(buffer.read(out));
+  EXPECT_EQ(out, text);
+  EXPECT_EQ(out.data(), data);
+
+  // a pinned value is copied into out, otherwise it is moved
+  auto handle = buffer.read_handle();
+  EXPECT_TRUE(buffer.take(out));
+  EXPECT_EQ(out, text);
+  EXPECT_EQ(handle->size(), 100);
+  handle.reset();
+  EXPECT_TRUE(buffer.write(std::string(50, 'y')));
+  EXPECT_TRUE(buffer.take(out));
+  EXPECT_EQ(out, std::string(50, 'y'));
+  EXPECT_FALSE(buffer.read(out));
+}
+
+TEST_F(TestExchangeBufferNonTrivial, move_only_values_are_written_and_taken) {
+  lockfree::ExchangeBuffer<std::unique_ptr<Counted>, 4> buffer;
+  EXPECT_TRUE(buffer.write(std::make_unique<Counted>("first")));
+  EXPECT_TRUE(buffer.emplace(std::make_unique<Counted>("second")));
+  EXPECT_EQ(Counted::instances, 1);
+
+  auto taken = buffer.take();
+  ASSERT_TRUE(taken.has_value());
+  EXPECT_EQ((*taken)->text, "second");
+  EXPECT_TRUE(buffer.empty());
+
+  std::unique_ptr<Counted> out;
+  EXPECT_FALSE(buffer.take(out));
+  EXPECT_TRUE(buffer.write(std::make_unique<Counted>("third")));
+  EXPECT_TRUE(buffer.take(out));
+  EXPECT_EQ(out->text, "third");
+
+  EXPECT_TRUE(buffer.write(std::make_unique<Counted>("fourth")));
+  auto handle = buffer.take_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_EQ((*handle)->text, "fourth");
+  handle.reset();
+  EXPECT_EQ(Counted::instances, 2);
+
+  // the buffer destroys the value it holds
+  EXPECT_TRUE(buffer.write(std::make_unique<Counted>("fifth")));
+  taken.reset();
+  out.reset();
+}
+
+TEST_F(TestExchangeBufferNonTrivial, emplace_and_try_write) {
+  lockfree::ExchangeBuffer<std::vector<int>, 4> buffer;
+  EXPECT_TRUE(buffer.emplace(3, 7));
+  EXPECT_FALSE(buffer.try_write({1}));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, std::vector<int>(3, 7));
+  EXPECT_TRUE(buffer.try_write({1}));
+  EXPECT_EQ(buffer.read()->size(), 1);
+}
+
+} // namespace
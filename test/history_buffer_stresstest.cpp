@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/history_buffer.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Writers write ascending values tagged with their id while readers read the
+// history. Each history read must be consistent (no torn values) and the
+// values of each writer must appear in descending order (newest first).
+
+constexpr int NUM_WRITER_THREADS = 4;
+constexpr int NUM_READER_THREADS = 4;
+constexpr uint32_t DEPTH = 8;
+
+constexpr std::chrono::seconds runtime(2);
+
+struct Data {
+  int id;
+  uint64_t value;
+  uint64_t check;
+};
+
+using Buffer =
+    lockfree::HistoryBuffer<Data, DEPTH, DEPTH + NUM_WRITER_THREADS>;
+
+void write(Buffer &buffer, std::atomic<bool> &run, int id, uint64_t &max) {
+  max = 0;
+  Data data{id, 1, ~1ULL};
+  while (run) {
+    if (buffer.write(data)) {
+      max = data.value;
+      ++data.value;
+      data.check = ~data.value;
+    }
+  }
+}
+
+void read(Buffer &buffer, std::atomic<bool> &run, int &consistent,
+          int &ordered, uint64_t &numRead) {
+  consistent = 1;
+  ordered = 1;
+  numRead = 0;
+  Data history[DEPTH];
+  while (run) {
+    auto n = buffer.read_last(history, DEPTH);
+    numRead += n;
+
+    std::array<uint64_t, NUM_WRITER_THREADS> prevValue;
+    prevValue.fill(UINT64_MAX);
+    for (uint32_t i = 0; i < n; ++i) {
+      auto &data = history[i];
+      if (data.check != ~data.value) {
+        consistent = 0;
+        continue;
+      }
+      if (data.value >= prevValue[data.id]) {
+        ordered = 0;
+      }
+      prevValue[data.id] = data.value;
+    }
+  }
+}
+
+TEST(HistoryBufferStressTest, history_is_consistent_and_ordered_per_writer) {
+  Buffer buffer;
+  std::vector<uint64_t> maxWritten(NUM_WRITER_THREADS, 0);
+  std::vector<int> consistent(NUM_READER_THREADS, 1);
+  std::vector<int> ordered(NUM_READER_THREADS, 1);
+  std::vector<uint64_t> numRead(NUM_READER_THREADS, 0);
+  std::vector<std::thread> writers;
+  std::vector<std::thread> readers;
+
+  std::atomic<bool> run{true};
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    readers.emplace_back(&read, std::ref(buffer), std::ref(run),
+                         std::ref(consistent[i]), std::ref(ordered[i]),
+                         std::ref(numRead[i]));
+  }
+
+  for (int i = 0; i < NUM_WRITER_THREADS; ++i) {
+    writers.emplace_back(&write, std::ref(buffer), std::ref(run), i,
+                         std::ref(maxWritten[i]));
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    std::cout << "read " << numRead[i] << std::endl;
+    EXPECT_EQ(consistent[i], 1);
+    EXPECT_EQ(ordered[i], 1);
+  }
+
+  // after the writers stopped the history contains the last values, the
+  // latest value of each writer must be among them
+  Data history[DEPTH];
+  ASSERT_EQ(buffer.read_last(history, DEPTH), DEPTH);
+  for (int id = 0; id < NUM_WRITER_THREADS; ++id) {
+    for (auto &data : history) {
+      if (data.id == id) {
+        EXPECT_EQ(data.value, maxWritten[id]);
+        break;
+      }
+    }
+  }
+}
+
+// a buffer that is not empty has a value to read (even while the first
+// write is still in progress)
+TEST(HistoryBufferStressTest, not_empty_buffer_has_latest_value) {
+  constexpr int ROUNDS = 1000;
+  int missing = 0;
+  for (int round = 0; round < ROUNDS; ++round) {
+    Buffer buffer;
+    std::thread writer([&] { buffer.write(Data{0, 1, ~1ULL}); });
+    while (buffer.empty()) {
+      std::this_thread::yield();
+    }
+    if (!buffer.read_latest()) {
+      ++missing;
+    }
+    writer.join();
+  }
+  EXPECT_EQ(missing, 0);
+}
+
+} // namespace
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/history_buffer.hpp"
+
+namespace {
+
+constexpr uint32_t DEPTH = 4;
+
+using IntBuffer = lockfree::HistoryBuffer<int, DEPTH>;
+
+class TestHistoryBuffer : public ::testing::Test {
+public:
+  IntBuffer buffer;
+  int values[2 * DEPTH];
+};
+
+TEST_F(TestHistoryBuffer, constructed_buffer_is_empty) {
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_FALSE(buffer.read_latest().has_value());
+  EXPECT_EQ(buffer.read_last(values, DEPTH), 0);
+}
+
+TEST_F(TestHistoryBuffer, read_latest_returns_last_value_written) {
+  EXPECT_TRUE(buffer.write(73));
+  EXPECT_TRUE(buffer.write(37));
+  EXPECT_FALSE(buffer.empty());
+  auto result = buffer.read_latest();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 37);
+
+  // reading does not remove the value
+  result = buffer.read_latest();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 37);
+}
+
+TEST_F(TestHistoryBuffer, read_last_returns_values_newest_first) {
+  EXPECT_TRUE(buffer.write(1));
+  EXPECT_TRUE(buffer.write(2));
+  EXPECT_TRUE(buffer.write(3));
+
+  ASSERT_EQ(buffer.read_last(values, 2), 2);
+  EXPECT_EQ(values[0], 3);
+  EXPECT_EQ(values[1], 2);
+
+  ASSERT_EQ(buffer.read_last(values, DEPTH), 3);
+  EXPECT_EQ(values[0], 3);
+  EXPECT_EQ(values[1], 2);
+  EXPECT_EQ(values[2], 1);
+}
+
+TEST_F(TestHistoryBuffer, buffer_keeps_only_the_last_depth_values) {
+  for (int i = 1; i <= 10; ++i) {
+    EXPECT_TRUE(buffer.write(i));
+  }
+
+  ASSERT_EQ(buffer.read_last(values, 2 * DEPTH), DEPTH);
+  for (uint32_t i = 0; i < DEPTH; ++i) {
+    EXPECT_EQ(values[i], 10 - static_cast<int>(i));
+  }
+}
+
+TEST_F(TestHistoryBuffer, slots_of_overwritten_values_are_reused) {
+  // more writes than slots
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(buffer.write(i));
+  }
+  auto result = buffer.read_latest();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 99);
+}
+
+} // namespace
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/cached_index_pool.hpp"
+#include "lockfree/exchange_buffer.hpp"
+#include "lockfree/free_list_index_pool.hpp"
+#include "lockfree/index_pool.hpp"
+
+#include <cstring>
+#include <future>
+#include <memory>
+#include <new>
+#include <set>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t POOL_SIZE = 8;
+
+template <class Pool> class TestIndexPool : public ::testing::Test {
+public:
+  Pool pool;
+};
+
+using Pools = ::testing::Types<lockfree::IndexPool<POOL_SIZE>,
+                               lockfree::FreeListIndexPool<POOL_SIZE>,
+                               lockfree::CachedIndexPool<POOL_SIZE>>;
+
+TYPED_TEST_SUITE(TestIndexPool, Pools);
+
+TYPED_TEST(TestIndexPool, all_indices_can_be_acquired_exactly_once) {
+  std::set<uint32_t> indices;
+  for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+    auto index = this->pool.get();
+    ASSERT_TRUE(index.has_value());
+    EXPECT_LT(*index, POOL_SIZE);
+    indices.insert(*index);
+  }
+  EXPECT_EQ(indices.size(), POOL_SIZE);
+}
+
+TYPED_TEST(TestIndexPool, get_fails_if_exhausted) {
+  for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+    ASSERT_TRUE(this->pool.get().has_value());
+  }
+  EXPECT_FALSE(this->pool.get().has_value());
+}
+
+TYPED_TEST(TestIndexPool, freed_index_can_be_acquired_again) {
+  for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+    ASSERT_TRUE(this->pool.get().has_value());
+  }
+  this->pool.free(3);
+  auto index = this->pool.get();
+  ASSERT_TRUE(index.has_value());
+  EXPECT_EQ(*index, 3);
+  EXPECT_FALSE(this->pool.get().has_value());
+}
+
+TEST(IndexPoolOwners, scavenge_reclaims_indices_of_dead_owners) {
+  lockfree::IndexPool<POOL_SIZE> pool;
+  lockfree::Owner alive{1, 1};
+  lockfree::Owner dead{2, 1};
+  auto kept = pool.get(alive);
+  auto lost1 = pool.get(dead);
+  auto lost2 = pool.get(dead);
+  auto anonymous = pool.get();
+  ASSERT_TRUE(kept && lost1 && lost2 && anonymous);
+  EXPECT_EQ(pool.owner(*lost1), dead);
+  EXPECT_TRUE(pool.owner(*anonymous).anonymous());
+
+  auto reclaimed =
+      pool.scavenge([&](lockfree::Owner owner) { return !(owner == dead); });
+  EXPECT_EQ(reclaimed, 2);
+
+  // the reclaimed indices (and only those) can be acquired again
+  std::set<uint32_t> indices;
+  while (auto index = pool.get()) {
+    indices.insert(*index);
+  }
+  EXPECT_EQ(indices.size(), POOL_SIZE - 2);
+  EXPECT_EQ(indices.count(*lost1), 1);
+  EXPECT_EQ(indices.count(*lost2), 1);
+  EXPECT_EQ(indices.count(*kept), 0);
+}
+
+TEST(IndexPoolOwners, disowned_and_reused_indices_are_not_reclaimed) {
+  lockfree::IndexPool<POOL_SIZE> pool;
+  lockfree::Owner dead{2, 1};
+  lockfree::Owner reincarnated{2, 2};
+  auto disowned = pool.get(dead);
+  auto reused = pool.get(reincarnated);
+  ASSERT_TRUE(disowned && reused);
+  pool.disown(*disowned);
+
+  EXPECT_EQ(pool.scavenge([&](lockfree::Owner owner) {
+    return !(owner == dead);
+  }),
+            0);
+  EXPECT_EQ(pool.owner(*reused), reincarnated);
+}
+
+// a pool destroyed while another thread caches its indices, followed by a
+// new pool at the same address
+TEST(CachedIndexPoolLifetime, magazines_of_destroyed_pool_are_dropped) {
+  using Pool = lockfree::CachedIndexPool<POOL_SIZE>;
+  alignas(Pool) unsigned char memory[sizeof(Pool)];
+  auto pool = new (memory) Pool;
+
+  std::promise<void> cached, replaced, done;
+  std::thread thread([&] {
+    // fills the magazine of the thread
+    pool->free(*pool->get());
+    cached.set_value();
+    replaced.get_future().wait();
+    // the cached indices of the old pool must not be handed out
+    std::set<uint32_t> indices;
+    uint32_t count = 0;
+    for (; auto index = pool->get(); ++count) {
+      indices.insert(*index);
+    }
+    EXPECT_EQ(count, POOL_SIZE);
+    EXPECT_EQ(indices.size(), POOL_SIZE);
+    for (auto index : indices) {
+      pool->free(index);
+    }
+    done.set_value();
+  });
+
+  cached.get_future().wait();
+  pool->~Pool();
+  std::memset(memory, 0xff, sizeof(memory));
+  pool = new (memory) Pool;
+  replaced.set_value();
+  done.get_future().wait();
+  thread.join();
+
+  // the thread returned its indices of the new pool when it exited
+  for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+    EXPECT_TRUE(pool->get().has_value());
+  }
+  pool->~Pool();
+}
+
+TEST(CachedIndexPoolLifetime, exiting_thread_skips_destroyed_pool) {
+  using Pool = lockfree::CachedIndexPool<POOL_SIZE>;
+  auto pool = std::make_unique<Pool>();
+
+  std::promise<void> cached, destroyed;
+  std::thread thread([&] {
+    pool->free(*pool->get());
+    cached.set_value();
+    destroyed.get_future().wait();
+  });
+
+  cached.get_future().wait();
+  pool.reset();
+  destroyed.set_value();
+  // would write into the freed pool (cf. AddressSanitizer)
+  thread.join();
+}
+
+TEST(ExchangeBufferWithFreeListIndexPool, write_overwrites_previous_value) {
+  lockfree::ExchangeBuffer<int, POOL_SIZE,
+                           lockfree::FreeListIndexPool<POOL_SIZE>>
+      buffer;
+  for (uint32_t i = 0; i < 3 * POOL_SIZE; ++i) {
+    EXPECT_TRUE(buffer.write(i));
+  }
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 3 * POOL_SIZE - 1);
+  EXPECT_TRUE(buffer.empty());
+}
+
+} // namespace
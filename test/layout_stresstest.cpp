@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/index_pool.hpp"
+#include "lockfree/layout.hpp"
+#include "lockfree/storage.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Compares the throughput of concurrent allocations with packed and padded
+// slot layouts of IndexPool and Storage. Writers acquire neighbouring indices
+// concurrently, with the packed layout they share cache lines (false sharing).
+//
+// This is a benchmark rather than a test, we only check that the payloads are
+// not corrupted and report the throughput.
+
+constexpr uint32_t NUM_SLOTS = 32;
+constexpr int THREAD_COUNTS[] = {2, 4, 8, 16};
+
+constexpr std::chrono::milliseconds runtime(250);
+
+struct Payload {
+  uint64_t value;
+  uint64_t check;
+};
+
+template <class Layout> struct Allocator {
+  lockfree::IndexPool<NUM_SLOTS, Layout> indices;
+  lockfree::Storage<Payload, NUM_SLOTS, uint32_t, Layout> storage;
+};
+
+template <class Layout>
+void allocate(Allocator<Layout> &allocator, std::atomic<bool> &run, int id,
+              uint64_t &numOps, uint64_t &numCorrupted) {
+  numOps = 0;
+  numCorrupted = 0;
+  uint64_t value = static_cast<uint64_t>(id) << 32;
+  while (run) {
+    auto index = allocator.indices.get();
+    if (!index) {
+      continue;
+    }
+    allocator.storage.store_at(Payload{value, ~value}, *index);
+    auto &payload = allocator.storage[*index];
+    if (payload.value != value || payload.check != ~value) {
+      ++numCorrupted;
+    }
+    allocator.storage.free(*index);
+    allocator.indices.free(*index);
+    ++value;
+    ++numOps;
+  }
+}
+
+template <class Layout> double measure_throughput(int numThreads) {
+  Allocator<Layout> allocator;
+  std::vector<uint64_t> ops(numThreads, 0);
+  std::vector<uint64_t> corrupted(numThreads, 0);
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+
+  std::atomic<bool> run{true};
+  for (int i = 0; i < numThreads; ++i) {
+    threads.emplace_back(&allocate<Layout>, std::ref(allocator), std::ref(run),
+                         i, std::ref(ops[i]), std::ref(corrupted[i]));
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (auto numCorrupted : corrupted) {
+    EXPECT_EQ(numCorrupted, 0);
+  }
+
+  auto totalOps = std::accumulate(ops.begin(), ops.end(), 0ULL);
+  return totalOps / std::chrono::duration<double>(runtime).count();
+}
+
+TEST(LayoutStressTest, throughput_of_packed_and_padded_slots) {
+  static_assert(sizeof(Allocator<lockfree::PackedLayout>) <
+                sizeof(Allocator<lockfree::PaddedLayout>));
+
+  for (auto numThreads : THREAD_COUNTS) {
+    auto packed = measure_throughput<lockfree::PackedLayout>(numThreads);
+    auto padded = measure_throughput<lockfree::PaddedLayout>(numThreads);
+
+    std::cout << numThreads << " writers: packed " << packed
+              << " ops/s, padded " << padded << " ops/s, ratio "
+              << padded / packed << std::endl;
+  }
+}
+
+} // namespace
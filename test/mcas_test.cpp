@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/mcas.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using MCas = lockfree::MCas<4, 16>;
+using word_t = MCas::word_t;
+
+TEST(TestMCas, cas_succeeds_if_all_words_are_expected) {
+  MCas mcas;
+  word_t a{1}, b{2}, c{3};
+  EXPECT_TRUE(mcas.cas({{&a, 1, 4}, {&b, 2, 5}, {&c, 3, 6}}));
+  EXPECT_EQ(mcas.read(a), 4);
+  EXPECT_EQ(mcas.read(b), 5);
+  EXPECT_EQ(mcas.read(c), 6);
+}
+
+TEST(TestMCas, cas_fails_if_one_word_is_not_expected) {
+  MCas mcas;
+  word_t a{1}, b{2}, c{3};
+  EXPECT_FALSE(mcas.cas({{&c, 3, 6}, {&a, 1, 4}, {&b, 7, 5}}));
+  EXPECT_EQ(mcas.read(a), 1);
+  EXPECT_EQ(mcas.read(b), 2);
+  EXPECT_EQ(mcas.read(c), 3);
+}
+
+TEST(TestMCas, cas_of_single_word) {
+  MCas mcas;
+  word_t a{MCas::MAX_VALUE};
+  EXPECT_TRUE(mcas.cas({{&a, MCas::MAX_VALUE, 0}}));
+  EXPECT_EQ(mcas.read(a), 0);
+  EXPECT_FALSE(mcas.cas({{&a, 1, 2}}));
+  EXPECT_EQ(mcas.read(a), 0);
+}
+
+TEST(TestMCas, cas_fails_for_more_than_max_words) {
+  MCas mcas;
+  word_t a{1}, b{2}, c{3}, d{4}, e{5};
+  EXPECT_FALSE(mcas.cas(
+      {{&a, 1, 0}, {&b, 2, 0}, {&c, 3, 0}, {&d, 4, 0}, {&e, 5, 0}}));
+  EXPECT_EQ(mcas.read(a), 1);
+  EXPECT_EQ(mcas.read(e), 5);
+}
+
+// Threads increment overlapping pairs of words (0,1), (1,2), ... of a ring,
+// i.e. the sum of all words is even in any consistent state. A checker
+// validates its snapshot of all words with an MCAS that does not change the
+// values.
+TEST(TestMCas, concurrent_increments_are_atomic) {
+  constexpr int NUM_WORDS = 4;
+  constexpr int NUM_THREADS = 4;
+  constexpr int NUM_INCREMENTS = 2000;
+  MCas mcas;
+  word_t words[NUM_WORDS];
+  for (auto &word : words) {
+    word.store(0);
+  }
+
+  std::vector<std::thread> threads;
+  std::atomic<bool> run{true};
+  std::atomic<int> inconsistent{0};
+  for (int t = 0; t < NUM_THREADS; ++t) {
+    threads.emplace_back([&, t] {
+      for (int n = 0; n < NUM_INCREMENTS; ++n) {
+        auto &first = words[(t + n) % NUM_WORDS];
+        auto &second = words[(t + n + 1) % NUM_WORDS];
+        while (true) {
+          auto a = mcas.read(first);
+          auto b = mcas.read(second);
+          if (mcas.cas({{&first, a, a + 1}, {&second, b, b + 1}})) {
+            break;
+          }
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::thread checker([&] {
+    while (run) {
+      uint64_t values[NUM_WORDS];
+      for (int i = 0; i < NUM_WORDS; ++i) {
+        values[i] = mcas.read(words[i]);
+      }
+      uint64_t sum = 0;
+      for (auto value : values) {
+        sum += value;
+      }
+      if (mcas.cas({{&words[0], values[0], values[0]},
+                    {&words[1], values[1], values[1]},
+                    {&words[2], values[2], values[2]},
+                    {&words[3], values[3], values[3]}}) &&
+          sum % 2 != 0) {
+        ++inconsistent;
+      }
+      std::this_thread::yield();
+    }
+  });
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  run = false;
+  checker.join();
+
+  uint64_t sum = 0;
+  for (auto &word : words) {
+    sum += mcas.read(word);
+  }
+  EXPECT_EQ(sum, 2 * NUM_THREADS * NUM_INCREMENTS);
+  EXPECT_EQ(inconsistent, 0);
+}
+
+} // namespace
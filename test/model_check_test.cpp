@@ -0,0 +1,380 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/exchange_buffer.hpp"
+#include "lockfree/index_pool.hpp"
+#include "lockfree/model_check.hpp"
+#include "lockfree/sync_counter.hpp"
+#include "lockfree/take_buffer.hpp"
+
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// requires LOCKFREE_MODEL_CHECK (cf. test/CMakeLists.txt)
+//
+// Each test explores many interleavings of a few operations (instead of
+// running many operations for some time like the stress tests). The
+// exhaustive runs cover all schedules with at most 2 preemptions.
+
+namespace {
+
+using lockfree::model::Options;
+using lockfree::model::require;
+using lockfree::model::Result;
+
+template <class Test> void expect_no_violation(const Options &options) {
+  Result result = lockfree::model::explore<Test>(options);
+  std::cout << result.executions << " executions"
+            << (result.complete ? " (complete)" : "") << std::endl;
+  EXPECT_TRUE(result.failure.empty()) << result.failure;
+  EXPECT_GT(result.executions, 0);
+}
+
+Options exhaustive() {
+  Options options;
+  options.strategy = Options::Strategy::Exhaustive;
+  options.executions = 200000;
+  options.preemptionBound = 2;
+  return options;
+}
+
+Options random(uint64_t seed) {
+  Options options;
+  options.strategy = Options::Strategy::Random;
+  options.executions = 5000;
+  options.seed = seed;
+  return options;
+}
+
+// note: copies of the payload are not scheduling points (cf. model_check.hpp),
+//       i.e. the tests detect values that are lost, duplicated or read from
+//       a reused slot, not torn copies
+struct Data {
+  Data() = default;
+  Data(uint64_t v) : a(v) {}
+  uint64_t a{0};
+};
+
+// all slots of a buffer can be loaned again (none leaked or freed twice)
+template <class Buffer, uint32_t C> bool all_slots_free(Buffer &buffer) {
+  std::vector<typename Buffer::loan_t> loans;
+  for (uint32_t i = 0; i < C; ++i) {
+    loans.push_back(buffer.loan());
+    if (!loans.back()) {
+      return false;
+    }
+  }
+  return !buffer.loan();
+}
+
+// two writers and a consumer that takes and reads concurrently
+struct ExchangeBufferWriteTake {
+  static constexpr uint32_t THREADS = 3;
+  static constexpr uint32_t C = 3;
+
+  lockfree::ExchangeBuffer<Data, C> buffer;
+  std::vector<uint64_t> consumed;
+
+  void run(uint32_t thread) {
+    if (thread < 2) {
+      require(buffer.write(Data(thread + 1)), "write failed");
+      return;
+    }
+    auto read = buffer.read();
+    if (read) {
+      require(read->a == 1 || read->a == 2, "read unwritten value");
+    }
+    auto taken = buffer.take();
+    if (taken) {
+      consumed.push_back(taken->a);
+    }
+  }
+
+  void check() {
+    auto last = buffer.take();
+    if (last) {
+      consumed.push_back(last->a);
+    }
+    // the last write is never lost, i.e. at least one value is consumed
+    require(!consumed.empty(), "all values lost");
+    std::set<uint64_t> unique(consumed.begin(), consumed.end());
+    require(unique.size() == consumed.size(), "value consumed twice");
+    for (auto value : consumed) {
+      require(value == 1 || value == 2, "consumed unwritten value");
+    }
+    require(buffer.empty(), "not empty after take");
+    require(all_slots_free<decltype(buffer), C>(buffer), "slot leaked");
+  }
+};
+
+// try_write does not discard values, i.e. every successful write is
+// consumed exactly once
+struct ExchangeBufferTryWrite {
+  static constexpr uint32_t THREADS = 3;
+  static constexpr uint32_t C = 2;
+
+  lockfree::ExchangeBuffer<Data, C> buffer;
+  bool written[2]{false, false};
+  std::vector<uint64_t> consumed;
+
+  void run(uint32_t thread) {
+    if (thread < 2) {
+      written[thread] = buffer.try_write(Data(thread + 1));
+      return;
+    }
+    auto taken = buffer.take();
+    if (taken) {
+      consumed.push_back(taken->a);
+    }
+  }
+
+  void check() {
+    auto last = buffer.take();
+    if (last) {
+      consumed.push_back(last->a);
+    }
+    std::multiset<uint64_t> expected;
+    for (uint64_t i = 0; i < 2; ++i) {
+      if (written[i]) {
+        expected.insert(i + 1);
+      }
+    }
+    require(!expected.empty(), "no try_write succeeded");
+    require(std::multiset<uint64_t>(consumed.begin(), consumed.end()) ==
+                expected,
+            "try_write value lost or duplicated");
+    require(all_slots_free<decltype(buffer), C>(buffer), "slot leaked");
+  }
+};
+
+// the reference counts of read handles: a slot is freed exactly once and
+// not while pinned
+struct ExchangeBufferHandles {
+  static constexpr uint32_t THREADS = 3;
+  static constexpr uint32_t C = 3;
+
+  lockfree::ExchangeBuffer<Data, C> buffer;
+
+  ExchangeBufferHandles() { buffer.write(Data(1)); }
+
+  void run(uint32_t thread) {
+    if (thread == 0) {
+      buffer.write(Data(2));
+    } else if (thread == 1) {
+      auto handle = buffer.read_handle();
+      if (handle) {
+        // the slot cannot be reused while we hold the handle
+        auto value = handle->a;
+        buffer.take();
+        require(handle->a == value, "pinned slot was reused");
+      }
+    } else {
+      auto handle = buffer.take_handle();
+      if (handle) {
+        require(handle->a == 1 || handle->a == 2, "took unwritten value");
+      }
+    }
+  }
+
+  void check() {
+    buffer.take();
+    require(all_slots_free<decltype(buffer), C>(buffer), "slot leaked");
+  }
+};
+
+// values that are not trivially copyable are only destroyed when no reader
+// copies them anymore
+struct ExchangeBufferNonTrivial {
+  static constexpr uint32_t THREADS = 3;
+  static constexpr uint32_t C = 3;
+
+  lockfree::ExchangeBuffer<std::string, C> buffer;
+
+  ExchangeBufferNonTrivial() { buffer.write(std::string(32, 'a')); }
+
+  void run(uint32_t thread) {
+    if (thread == 0) {
+      buffer.write(std::string(32, 'b'));
+      buffer.write(std::string(32, 'c'));
+    } else if (thread == 1) {
+      auto value = buffer.read();
+      if (value) {
+        require(value->size() == 32 &&
+                    value->find_first_not_of((*value)[0]) == std::string::npos,
+                "corrupted read");
+      }
+    } else {
+      buffer.take();
+    }
+  }
+
+  void check() {
+    buffer.take();
+    require(all_slots_free<decltype(buffer), C>(buffer), "slot leaked");
+  }
+};
+
+struct TakeBufferWriteTake {
+  static constexpr uint32_t THREADS = 3;
+  static constexpr uint32_t C = 3;
+
+  lockfree::TakeBuffer<Data, C> buffer;
+  bool written[2]{false, false};
+  std::vector<uint64_t> consumed;
+
+  void run(uint32_t thread) {
+    if (thread < 2) {
+      written[thread] = buffer.try_write(Data(thread + 1));
+      return;
+    }
+    auto taken = buffer.take();
+    if (taken) {
+      consumed.push_back(taken->a);
+    }
+  }
+
+  void check() {
+    auto last = buffer.take();
+    if (last) {
+      consumed.push_back(last->a);
+    }
+    std::multiset<uint64_t> expected;
+    for (uint64_t i = 0; i < 2; ++i) {
+      if (written[i]) {
+        expected.insert(i + 1);
+      }
+    }
+    require(std::multiset<uint64_t>(consumed.begin(), consumed.end()) ==
+                expected,
+            "try_write value lost or duplicated");
+    require(all_slots_free<decltype(buffer), C>(buffer), "slot leaked");
+  }
+};
+
+// more threads than indices, indices are never handed out twice
+struct IndexPoolGetFree {
+  static constexpr uint32_t THREADS = 3;
+  static constexpr uint32_t C = 2;
+
+  lockfree::IndexPool<C> pool;
+  lockfree::model::atomic<uint32_t> owners[C];
+
+  IndexPoolGetFree() {
+    for (auto &owner : owners) {
+      owner.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void run(uint32_t) {
+    for (int i = 0; i < 2; ++i) {
+      auto index = pool.get();
+      if (!index) {
+        continue;
+      }
+      require(owners[*index].fetch_add(1) == 0, "index owned twice");
+      owners[*index].fetch_sub(1);
+      pool.free(*index);
+    }
+  }
+
+  void check() {
+    std::set<uint32_t> indices;
+    while (auto index = pool.get()) {
+      indices.insert(*index);
+    }
+    require(indices.size() == C, "index leaked");
+  }
+};
+
+// two increments and a concurrent sync (that may have to help)
+struct SyncCounterIncrementSync {
+  static constexpr uint32_t THREADS = 3;
+
+  lockfree::SyncCounter counter;
+
+  void run(uint32_t thread) {
+    if (thread < 2) {
+      counter.increment();
+      return;
+    }
+    auto first = counter.sync();
+    auto second = counter.sync();
+    require(first <= second, "sync is not monotonic");
+    require(second <= 2, "sync counted too many increments");
+    // an increment may still be pending (but at most one counter ahead)
+    auto values = counter.get_if_equal();
+    require(values.first == values.second ||
+                values.first == values.second + 1,
+            "counters differ by more than 1");
+  }
+
+  void check() {
+    require(counter.sync() == 2, "increment lost");
+    auto values = counter.get_if_equal();
+    require(values.first == 2 && values.second == 2, "counters differ");
+  }
+};
+
+// a racy increment (load and store) to validate the checker itself
+struct RacyIncrement {
+  static constexpr uint32_t THREADS = 2;
+
+  lockfree::model::atomic<uint64_t> count{0};
+
+  void run(uint32_t) {
+    auto value = count.load();
+    count.store(value + 1);
+  }
+
+  void check() { require(count.load() == 2, "increment lost"); }
+};
+
+TEST(ModelCheck, finds_lost_update_of_racy_increment) {
+  auto result = lockfree::model::explore<RacyIncrement>(exhaustive());
+  EXPECT_EQ(result.failure, "increment lost");
+  EXPECT_FALSE(result.schedule.empty());
+}
+
+TEST(ModelCheck, exhaustive_exploration_completes) {
+  auto result = lockfree::model::explore<SyncCounterIncrementSync>(exhaustive());
+  EXPECT_TRUE(result.failure.empty()) << result.failure;
+  EXPECT_TRUE(result.complete);
+}
+
+TEST(ModelCheck, exchange_buffer_write_take) {
+  expect_no_violation<ExchangeBufferWriteTake>(exhaustive());
+  expect_no_violation<ExchangeBufferWriteTake>(random(1));
+}
+
+TEST(ModelCheck, exchange_buffer_try_write) {
+  expect_no_violation<ExchangeBufferTryWrite>(exhaustive());
+  expect_no_violation<ExchangeBufferTryWrite>(random(2));
+}
+
+TEST(ModelCheck, exchange_buffer_handles) {
+  expect_no_violation<ExchangeBufferHandles>(exhaustive());
+  expect_no_violation<ExchangeBufferHandles>(random(3));
+}
+
+TEST(ModelCheck, exchange_buffer_non_trivial) {
+  expect_no_violation<ExchangeBufferNonTrivial>(exhaustive());
+  expect_no_violation<ExchangeBufferNonTrivial>(random(7));
+}
+
+TEST(ModelCheck, take_buffer_write_take) {
+  expect_no_violation<TakeBufferWriteTake>(exhaustive());
+  expect_no_violation<TakeBufferWriteTake>(random(4));
+}
+
+TEST(ModelCheck, index_pool_get_free) {
+  expect_no_violation<IndexPoolGetFree>(exhaustive());
+  expect_no_violation<IndexPoolGetFree>(random(5));
+}
+
+TEST(ModelCheck, sync_counter_increment_sync) {
+  expect_no_violation<SyncCounterIncrementSync>(exhaustive());
+  expect_no_violation<SyncCounterIncrementSync>(random(6));
+}
+
+} // namespace
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/queue.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Producers push ascending values tagged with their id, consumers pop them
+// (single values and batches). No value may be lost or duplicated and the
+// values of each producer must be popped in order by each consumer.
+
+constexpr int NUM_PRODUCER_THREADS = 4;
+constexpr int NUM_CONSUMER_THREADS = 4;
+constexpr uint32_t BATCH_SIZE = 4;
+
+constexpr std::chrono::seconds runtime(2);
+
+struct Data {
+  int id;
+  uint64_t value;
+};
+
+using Queue = lockfree::Queue<Data, 16>;
+
+void push(Queue &queue, std::atomic<bool> &run, int id, uint64_t &max) {
+  max = 0;
+  Data batch[BATCH_SIZE];
+  bool useBatch = id % 2 == 0;
+  while (run) {
+    if (useBatch) {
+      for (uint32_t i = 0; i < BATCH_SIZE; ++i) {
+        batch[i] = Data{id, max + i + 1};
+      }
+      auto n = queue.try_push_batch(batch, BATCH_SIZE);
+      max += n;
+      if (n < BATCH_SIZE) {
+        std::this_thread::yield(); // full
+      }
+    } else if (queue.try_push(Data{id, max + 1})) {
+      ++max;
+    } else {
+      std::this_thread::yield(); // full
+    }
+  }
+}
+
+void pop(Queue &queue, std::atomic<bool> &run, int id, uint64_t &sum,
+         int &ordered) {
+  sum = 0;
+  ordered = 1;
+  std::array<uint64_t, NUM_PRODUCER_THREADS> prevValue{0};
+  Data batch[BATCH_SIZE];
+  bool useBatch = id % 2 == 0;
+
+  auto consume = [&](const Data &data) {
+    sum += data.value;
+    if (data.value <= prevValue[data.id]) {
+      ordered = 0;
+    }
+    prevValue[data.id] = data.value;
+  };
+
+  while (run) {
+    if (useBatch) {
+      auto n = queue.try_pop_batch(batch, BATCH_SIZE);
+      for (uint32_t i = 0; i < n; ++i) {
+        consume(batch[i]);
+      }
+      if (n == 0) {
+        std::this_thread::yield(); // empty
+      }
+    } else if (auto result = queue.try_pop()) {
+      consume(*result);
+    } else {
+      std::this_thread::yield(); // empty
+    }
+  }
+}
+
+uint64_t gauss_sum(uint64_t n) { return n * (n + 1) / 2; }
+
+TEST(QueueStressTest, no_data_is_lost_and_data_arrives_in_order) {
+  Queue queue;
+  std::vector<uint64_t> maxs(NUM_PRODUCER_THREADS, 0);
+  std::vector<uint64_t> sums(NUM_CONSUMER_THREADS, 0);
+  std::vector<int> ordered(NUM_CONSUMER_THREADS, 1);
+  std::vector<std::thread> producers;
+  std::vector<std::thread> consumers;
+
+  std::atomic<bool> runConsumers{true};
+  std::atomic<bool> runProducers{true};
+  // interleave producers and consumers, otherwise a single producer may
+  // dominate on machines with few cores
+  static_assert(NUM_PRODUCER_THREADS == NUM_CONSUMER_THREADS);
+  for (int i = 0; i < NUM_PRODUCER_THREADS; ++i) {
+    consumers.emplace_back(&pop, std::ref(queue), std::ref(runConsumers), i,
+                           std::ref(sums[i]), std::ref(ordered[i]));
+    producers.emplace_back(&push, std::ref(queue), std::ref(runProducers), i,
+                           std::ref(maxs[i]));
+  }
+
+  std::this_thread::sleep_for(runtime);
+  runProducers = false;
+
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  runConsumers = false;
+
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+
+  uint64_t expectedSum = 0;
+  for (auto max : maxs) {
+    std::cout << "pushed " << max << std::endl;
+    expectedSum += gauss_sum(max);
+  }
+
+  auto sum = std::accumulate(sums.begin(), sums.end(), 0ULL);
+  while (auto result = queue.try_pop()) {
+    sum += result->value;
+  }
+
+  EXPECT_EQ(expectedSum, sum);
+
+  for (auto orderedPop : ordered) {
+    EXPECT_EQ(orderedPop, 1);
+  }
+}
+
+} // namespace
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/queue.hpp"
+
+namespace {
+
+constexpr uint32_t CAPACITY = 8;
+
+using IntQueue = lockfree::Queue<int, CAPACITY>;
+
+class TestQueue : public ::testing::Test {
+public:
+  IntQueue queue;
+};
+
+TEST_F(TestQueue, constructed_queue_is_empty) {
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.try_pop().has_value());
+}
+
+TEST_F(TestQueue, values_are_popped_in_fifo_order) {
+  EXPECT_TRUE(queue.try_push(1));
+  EXPECT_TRUE(queue.try_push(2));
+  EXPECT_TRUE(queue.try_push(3));
+  EXPECT_FALSE(queue.empty());
+
+  for (int expected = 1; expected <= 3; ++expected) {
+    auto result = queue.try_pop();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, expected);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(TestQueue, push_fails_if_full) {
+  for (uint32_t i = 0; i < CAPACITY; ++i) {
+    EXPECT_TRUE(queue.try_push(i));
+  }
+  EXPECT_FALSE(queue.try_push(73));
+
+  auto result = queue.try_pop();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 0);
+  EXPECT_TRUE(queue.try_push(73));
+}
+
+TEST_F(TestQueue, queue_can_be_used_for_many_rounds) {
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(queue.try_push(i));
+    EXPECT_TRUE(queue.try_push(i + 1));
+    auto result = queue.try_pop();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, i);
+    result = queue.try_pop();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, i + 1);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(TestQueue, batches_are_pushed_and_popped_in_order) {
+  int values[] = {1, 2, 3, 4, 5};
+  EXPECT_EQ(queue.try_push_batch(values, 5), 5);
+  EXPECT_TRUE(queue.try_push(6));
+
+  int popped[CAPACITY];
+  ASSERT_EQ(queue.try_pop_batch(popped, 4), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(popped[i], i + 1);
+  }
+
+  ASSERT_EQ(queue.try_pop_batch(popped, CAPACITY), 2);
+  EXPECT_EQ(popped[0], 5);
+  EXPECT_EQ(popped[1], 6);
+  EXPECT_EQ(queue.try_pop_batch(popped, CAPACITY), 0);
+}
+
+TEST_F(TestQueue, batch_push_is_partial_if_queue_runs_full) {
+  int values[CAPACITY + 2] = {};
+  EXPECT_EQ(queue.try_push_batch(values, 3), 3);
+  EXPECT_EQ(queue.try_push_batch(values, CAPACITY + 2), CAPACITY - 3);
+  EXPECT_EQ(queue.try_push_batch(values, 1), 0);
+}
+
+} // namespace
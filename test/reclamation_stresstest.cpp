@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/pointer_exchange_buffer.hpp"
+#include "lockfree/reclamation.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Concurrent threads allocate, unlink and retire objects while others
+// access them. We check that no object is accessed after it was deleted
+// (canary, best run with AddressSanitizer), that no object is leaked and
+// that a CAS on a pointer does not suffer from ABA.
+
+constexpr int NUM_WRITER_THREADS = 4;
+constexpr int NUM_READER_THREADS = 4;
+
+constexpr std::chrono::seconds runtime(2);
+
+constexpr uint64_t ALIVE = 0xa11ea11ea11ea11e;
+
+// counts its live instances, the canary is destroyed with the object
+struct Counted {
+  static inline std::atomic<int64_t> instances{0};
+
+  Counted(uint64_t value) : value(value) { ++instances; }
+  Counted(const Counted &other) : value(other.value) { ++instances; }
+  ~Counted() {
+    canary = 0;
+    --instances;
+  }
+
+  uint64_t canary{ALIVE};
+  uint64_t value;
+};
+
+template <class Domain> class ReclamationStressTest : public ::testing::Test {
+public:
+  void SetUp() override { Counted::instances = 0; }
+};
+
+using Domains =
+    ::testing::Types<lockfree::HazardPointerDomain<>, lockfree::EpochDomain<>>;
+
+TYPED_TEST_SUITE(ReclamationStressTest, Domains);
+
+TYPED_TEST(ReclamationStressTest, read_values_are_alive_and_none_leak) {
+  auto domain = std::make_unique<TypeParam>();
+  auto buffer = std::make_unique<
+      lockfree::PointerExchangeBuffer<Counted, TypeParam>>(*domain);
+  std::atomic<bool> run{true};
+  std::atomic<int> corrupted{0};
+  std::atomic<uint64_t> numRead{0};
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_WRITER_THREADS; ++i) {
+    threads.emplace_back([&] {
+      uint64_t value = 0;
+      while (run) {
+        buffer->write(Counted(value++));
+      }
+    });
+  }
+  for (int i = 0; i < NUM_READER_THREADS; ++i) {
+    threads.emplace_back([&, i] {
+      while (run) {
+        // half of the readers also take values
+        auto result = i % 2 ? buffer->take() : buffer->read();
+        if (result) {
+          ++numRead;
+          if (result->canary != ALIVE) {
+            ++corrupted;
+          }
+        }
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::cout << "read " << numRead << std::endl;
+  EXPECT_EQ(corrupted, 0);
+
+  buffer.reset();
+  domain.reset();
+  EXPECT_EQ(Counted::instances, 0);
+}
+
+// Treiber stack whose pop is prone to ABA without reclamation: the popped
+// node could be deleted, reallocated and pushed again between the load of
+// the top and the CAS, which would then install a stale next pointer.
+template <class Domain> class Stack {
+public:
+  explicit Stack(Domain &domain) : m_domain(domain) {}
+
+  ~Stack() {
+    while (auto node = m_top.load()) {
+      m_top.store(node->next);
+      delete node;
+    }
+  }
+
+  void push(uint64_t value) {
+    auto node = new Node{value, m_top.load(std::memory_order_relaxed)};
+    while (!m_top.compare_exchange_weak(node->next, node,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+
+  bool pop(uint64_t &value) {
+    auto guard = m_domain.guard();
+    while (true) {
+      auto node = guard.protect(m_top);
+      if (!node) {
+        return false;
+      }
+      // the node cannot be deleted (and its address reused) while protected
+      if (m_top.compare_exchange_strong(node, node->next,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+        value = node->value;
+        guard.reset();
+        m_domain.retire(node);
+        return true;
+      }
+    }
+  }
+
+private:
+  struct Node {
+    uint64_t value;
+    Node *next;
+  };
+
+  std::atomic<Node *> m_top{nullptr};
+  Domain &m_domain;
+};
+
+TYPED_TEST(ReclamationStressTest, stack_pop_does_not_suffer_from_aba) {
+  constexpr int NUM_THREADS = NUM_WRITER_THREADS + NUM_READER_THREADS;
+  auto domain = std::make_unique<TypeParam>();
+  auto stack = std::make_unique<Stack<TypeParam>>(*domain);
+  std::atomic<bool> run{true};
+  std::vector<uint64_t> pushed(NUM_THREADS, 0);
+  std::vector<uint64_t> popped(NUM_THREADS, 0);
+
+  // each thread pushes values and pops (any) values, with ABA values would
+  // get lost or popped twice
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([&, i] {
+      uint64_t value = 0;
+      uint64_t count = 0;
+      while (run) {
+        stack->push(++count);
+        pushed[i] += count;
+        if (stack->pop(value)) {
+          popped[i] += value;
+        }
+        if (count % 2 && stack->pop(value)) {
+          popped[i] += value;
+        }
+      }
+    });
+  }
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t remaining = 0;
+  uint64_t value;
+  while (stack->pop(value)) {
+    remaining += value;
+  }
+
+  uint64_t totalPushed = 0;
+  uint64_t totalPopped = remaining;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    totalPushed += pushed[i];
+    totalPopped += popped[i];
+  }
+  std::cout << "pushed " << totalPushed << std::endl;
+  EXPECT_EQ(totalPushed, totalPopped);
+}
+
+} // namespace
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/pointer_exchange_buffer.hpp"
+#include "lockfree/reclamation.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// counts its live instances
+struct Counted {
+  static inline std::atomic<int> instances{0};
+
+  Counted() { ++instances; }
+  Counted(const Counted &) { ++instances; }
+  ~Counted() { --instances; }
+};
+
+template <class Domain> class TestReclamation : public ::testing::Test {
+public:
+  void SetUp() override { Counted::instances = 0; }
+
+  // an epoch domain needs two epochs to reclaim
+  void reclaim() {
+    for (int i = 0; i < 3; ++i) {
+      domain.reclaim();
+    }
+  }
+
+  Domain domain;
+};
+
+using Domains =
+    ::testing::Types<lockfree::HazardPointerDomain<4, 2>, lockfree::EpochDomain<4, 8>>;
+
+TYPED_TEST_SUITE(TestReclamation, Domains);
+
+TYPED_TEST(TestReclamation, retired_object_is_deleted_by_reclaim) {
+  this->domain.retire(new Counted);
+  EXPECT_EQ(Counted::instances, 1);
+  this->reclaim();
+  EXPECT_EQ(Counted::instances, 0);
+}
+
+TYPED_TEST(TestReclamation, protected_object_is_not_deleted) {
+  std::atomic<Counted *> ptr{new Counted};
+  auto guard = this->domain.guard();
+  auto protectedPtr = guard.protect(ptr);
+  EXPECT_EQ(protectedPtr, ptr.load());
+
+  // unlink and retire
+  ptr.store(nullptr);
+  this->domain.retire(protectedPtr);
+  this->reclaim();
+  EXPECT_EQ(Counted::instances, 1);
+
+  guard.reset();
+  this->reclaim();
+  EXPECT_EQ(Counted::instances, 0);
+}
+
+TYPED_TEST(TestReclamation, retire_lists_are_scanned_in_batches) {
+  for (int i = 0; i < 1000; ++i) {
+    this->domain.retire(new Counted);
+    // bounded without explicit reclaim
+    EXPECT_LE(Counted::instances, 32);
+  }
+}
+
+TYPED_TEST(TestReclamation, objects_retired_by_exited_thread_are_reclaimed) {
+  std::thread thread([&] { this->domain.retire(new Counted); });
+  thread.join();
+  EXPECT_EQ(Counted::instances, 1);
+  // the record (with its retired object) is adopted by the next thread
+  std::thread adopter([&] { this->reclaim(); });
+  adopter.join();
+  EXPECT_EQ(Counted::instances, 0);
+}
+
+// more live threads than records (MaxThreads = 4), the threads that do not
+// cache a record claim one per operation instead of waiting forever
+TYPED_TEST(TestReclamation, more_live_threads_than_records) {
+  constexpr int NUM_THREADS = 8;
+  lockfree::PointerExchangeBuffer<Counted, TypeParam> buffer(this->domain);
+  std::atomic<int> done{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([&] {
+      EXPECT_TRUE(buffer.write(Counted()));
+      buffer.read();
+      ++done;
+      // stay alive (with a cached record) until all threads are done
+      while (done < NUM_THREADS) {
+        std::this_thread::yield();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(done, NUM_THREADS);
+}
+
+TYPED_TEST(TestReclamation, domain_deletes_remaining_objects) {
+  {
+    TypeParam domain;
+    std::atomic<Counted *> ptr{new Counted};
+    {
+      auto guard = domain.guard();
+      domain.retire(guard.protect(ptr));
+    }
+    EXPECT_EQ(Counted::instances, 1);
+  }
+  EXPECT_EQ(Counted::instances, 0);
+}
+
+TYPED_TEST(TestReclamation, pointer_exchange_buffer_operations) {
+  {
+    lockfree::PointerExchangeBuffer<std::string, TypeParam> buffer(
+        this->domain);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_FALSE(buffer.read().has_value());
+    EXPECT_TRUE(buffer.write(std::string(100, 'a')));
+    EXPECT_FALSE(buffer.try_write("b"));
+    EXPECT_TRUE(buffer.write("c"));
+    EXPECT_EQ(buffer.read().value_or(""), "c");
+    EXPECT_EQ(buffer.take().value_or(""), "c");
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_FALSE(buffer.take().has_value());
+    EXPECT_TRUE(buffer.try_write("d"));
+    EXPECT_EQ(buffer.read().value_or(""), "d");
+  }
+  {
+    lockfree::PointerExchangeBuffer<Counted, TypeParam> buffer(this->domain);
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_TRUE(buffer.write(Counted()));
+    }
+    buffer.take();
+  }
+  this->reclaim();
+  EXPECT_EQ(Counted::instances, 0);
+}
+
+} // namespace
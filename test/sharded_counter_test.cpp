@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/sharded_counter.hpp"
+#include "lockfree/sync_counter.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <class Counter> class TestShardedCounter : public ::testing::Test {};
+
+using Counters =
+    ::testing::Types<lockfree::ShardedCounter<>,
+                     lockfree::ShardedCounter<lockfree::SyncCounter>>;
+TYPED_TEST_SUITE(TestShardedCounter, Counters);
+
+TYPED_TEST(TestShardedCounter, number_of_shards_is_power_of_two) {
+  TypeParam counter(5);
+  EXPECT_EQ(counter.shards(), 8);
+  TypeParam single(1);
+  EXPECT_EQ(single.shards(), 1);
+}
+
+TYPED_TEST(TestShardedCounter, increment) {
+  TypeParam counter;
+  EXPECT_EQ(counter.sync(), 0);
+  counter.increment();
+  counter.increment();
+  EXPECT_EQ(counter.get(), 2);
+  EXPECT_EQ(counter.sync(), 2);
+}
+
+TYPED_TEST(TestShardedCounter, concurrent_increments_are_not_lost) {
+  constexpr int NUM_THREADS = 6;
+  constexpr int NUM_INCREMENTS = 10000;
+  TypeParam counter(4);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < NUM_INCREMENTS; ++j) {
+        counter.increment();
+      }
+    });
+  }
+
+  // concurrent reads never decrease
+  uint64_t last = 0;
+  for (int i = 0; i < 100; ++i) {
+    auto value = counter.sync();
+    EXPECT_GE(value, last);
+    last = value;
+    std::this_thread::yield();
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.sync(), NUM_THREADS * NUM_INCREMENTS);
+}
+
+} // namespace
@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/shm_exchange_buffer.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr uint32_t CAPACITY = 2;
+
+struct Data {
+  Data() = default;
+  Data(uint64_t v) : a(v), b(v) {}
+  uint64_t a{0};
+  uint64_t b{0};
+};
+
+using Shm = lockfree::ShmExchangeBuffer<Data, CAPACITY>;
+
+class TestShmExchangeBuffer : public ::testing::Test {
+public:
+  std::string name = "/lockfree_test_" + std::to_string(getpid());
+
+  void SetUp() override { Shm::remove(name); }
+  void TearDown() override { Shm::remove(name); }
+
+  // run f in a child process, returns its exit code
+  template <class F> int in_child(F &&f) {
+    auto pid = fork();
+    if (pid == 0) {
+      _exit(f());
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+};
+
+TEST_F(TestShmExchangeBuffer, attached_mapping_shares_the_buffer) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+  auto attached = Shm::attach(name);
+  ASSERT_TRUE(attached.has_value());
+  // two mappings of the segment at different addresses
+  EXPECT_NE(&**creator, &**attached);
+
+  EXPECT_TRUE((*creator)->write(Data(73)));
+  auto value = (*attached)->take();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->a, 73);
+  EXPECT_TRUE((*creator)->empty());
+}
+
+TEST_F(TestShmExchangeBuffer, create_fails_if_segment_exists) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+  EXPECT_FALSE(Shm::create(name).has_value());
+}
+
+TEST_F(TestShmExchangeBuffer, attach_fails_if_segment_does_not_exist) {
+  EXPECT_FALSE(Shm::attach(name, 10ms).has_value());
+}
+
+TEST_F(TestShmExchangeBuffer, attach_fails_for_another_layout) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+  EXPECT_FALSE((lockfree::ShmExchangeBuffer<uint64_t, CAPACITY>::attach(
+                    name, 10ms)
+                    .has_value()));
+  EXPECT_FALSE(
+      (lockfree::ShmExchangeBuffer<Data, 4>::attach(name, 10ms).has_value()));
+}
+
+TEST_F(TestShmExchangeBuffer, values_are_exchanged_between_processes) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+
+  auto code = in_child([&] {
+    auto shm = Shm::attach(name);
+    if (!shm) {
+      return 1;
+    }
+    return (*shm)->write(Data(21)) ? 0 : 2;
+  });
+  ASSERT_EQ(code, 0);
+
+  auto value = (*creator)->read();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->a, 21);
+  EXPECT_EQ(value->b, 21);
+  // the child detached when it exited
+  EXPECT_EQ(creator->dead_participants(), 0);
+}
+
+TEST_F(TestShmExchangeBuffer, take_wait_is_woken_by_another_process) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+
+  auto pid = fork();
+  if (pid == 0) {
+    auto shm = Shm::attach(name);
+    std::this_thread::sleep_for(50ms);
+    _exit(shm && (*shm)->write(Data(42)) ? 0 : 1);
+  }
+  auto value = (*creator)->take_wait(5s);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->a, 42);
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST_F(TestShmExchangeBuffer, attach_concurrent_to_create_keeps_its_entry) {
+  auto pid = fork();
+  if (pid == 0) {
+    // attach as soon as the segment exists (possibly before it is READY)
+    std::optional<Shm> shm;
+    for (int i = 0; i < 1000 && !shm; ++i) {
+      shm = Shm::attach(name, 10ms);
+      if (!shm) {
+        std::this_thread::sleep_for(1ms);
+      }
+    }
+    if (!shm || !(*shm)->write(Data(3))) {
+      _exit(1);
+    }
+    std::this_thread::sleep_for(200ms);
+    _exit(0);
+  }
+
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+  auto value = (*creator)->take_wait(5s);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->a, 3);
+  // the entry of the attached (live) process was not overwritten
+  EXPECT_FALSE(creator->reset());
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST_F(TestShmExchangeBuffer, reset_recovers_slots_leaked_by_dead_process) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+
+  // the child dies while holding all slots
+  auto code = in_child([&] {
+    auto shm = Shm::attach(name);
+    if (!shm) {
+      return 1;
+    }
+    auto loan1 = (*shm)->loan();
+    auto loan2 = (*shm)->loan();
+    _exit(loan1 && loan2 ? 0 : 2);
+    return 0;
+  });
+  ASSERT_EQ(code, 0);
+
+  EXPECT_FALSE((*creator)->write(Data(1)));
+  EXPECT_EQ(creator->dead_participants(), 1);
+
+  EXPECT_TRUE(creator->reset());
+  EXPECT_EQ(creator->generation(), 1);
+  EXPECT_EQ(creator->dead_participants(), 0);
+  EXPECT_TRUE((*creator)->empty());
+  EXPECT_TRUE((*creator)->write(Data(1)));
+  EXPECT_TRUE((*creator)->write(Data(2)));
+}
+
+TEST_F(TestShmExchangeBuffer, scavenge_reclaims_loans_of_dead_process) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+  auto attached = Shm::attach(name);
+  ASSERT_TRUE(attached.has_value());
+
+  // the child publishes a value (owned by the buffer afterwards) and dies
+  // while holding the other slot
+  auto code = in_child([&] {
+    auto shm = Shm::attach(name);
+    if (!shm || !(*shm)->write(Data(7))) {
+      return 1;
+    }
+    auto loan = (*shm)->loan();
+    _exit(loan ? 0 : 2);
+    return 0;
+  });
+  ASSERT_EQ(code, 0);
+  EXPECT_EQ(creator->dead_participants(), 1);
+  EXPECT_FALSE((*creator)->loan());
+
+  // reclaimed while another participant is alive (reset fails)
+  EXPECT_FALSE(creator->reset());
+  EXPECT_EQ(creator->scavenge(), 1);
+  EXPECT_EQ(creator->scavenge(), 0);
+  EXPECT_EQ(creator->dead_participants(), 0);
+
+  auto value = (*attached)->read();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->a, 7);
+  EXPECT_TRUE((*attached)->write(Data(8)));
+  EXPECT_TRUE((*creator)->write(Data(9)));
+  value = (*attached)->take();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->a, 9);
+}
+
+TEST_F(TestShmExchangeBuffer, slots_of_live_processes_are_not_scavenged) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+  auto loan = (*creator)->loan();
+  ASSERT_TRUE(loan);
+  EXPECT_EQ(creator->scavenge(), 0);
+  loan.emplace(Data(5));
+  EXPECT_TRUE((*creator)->publish(std::move(loan)));
+  EXPECT_EQ(creator->scavenge(), 0);
+  auto value = (*creator)->take();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->a, 5);
+}
+
+TEST_F(TestShmExchangeBuffer, reset_fails_while_other_participant_is_alive) {
+  auto creator = Shm::create(name);
+  ASSERT_TRUE(creator.has_value());
+  auto attached = Shm::attach(name);
+  ASSERT_TRUE(attached.has_value());
+
+  EXPECT_TRUE((*creator)->write(Data(1)));
+  EXPECT_FALSE(creator->reset());
+  EXPECT_EQ(creator->generation(), 0);
+  EXPECT_FALSE((*attached)->empty());
+
+  // the buffer is usable after the failed reset
+  auto value = (*attached)->take();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(value->a, 1);
+}
+
+} // namespace
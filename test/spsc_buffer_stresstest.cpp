@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/spsc_exchange_buffer.hpp"
+#include "lockfree/spsc_take_buffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+// One producer and one consumer thread use the SPSC buffers concurrently.
+// Like the other stress tests, success cannot prove correctness.
+
+constexpr std::chrono::seconds runtime(2);
+
+uint64_t gauss_sum(uint64_t n) { return n * (n + 1) / 2; }
+
+// all entries are equal, a mix of entries indicates a corrupted value
+struct Sample {
+  static constexpr int SIZE = 16;
+  uint64_t values[SIZE];
+
+  Sample(uint64_t value = 0) {
+    for (auto &v : values) {
+      v = value;
+    }
+  }
+
+  bool consistent() const {
+    for (auto v : values) {
+      if (v != values[0]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// with try_write and take no data may be lost
+template <class Buffer> void try_write_and_take_lose_no_data() {
+  Buffer buffer;
+  std::atomic<bool> run{true};
+  uint64_t max = 0;
+  uint64_t sum = 0;
+
+  std::thread producer([&] {
+    while (run) {
+      if (buffer.try_write(max + 1)) {
+        ++max;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::thread consumer([&] {
+    while (run) {
+      if (auto result = buffer.take()) {
+        sum += *result;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+  producer.join();
+  consumer.join();
+
+  if (auto result = buffer.take()) {
+    sum += *result;
+  }
+
+  std::cout << "wrote " << max << std::endl;
+  EXPECT_EQ(gauss_sum(max), sum);
+}
+
+TEST(SpscBufferStressTest, exchange_buffer_loses_no_data_with_try_write) {
+  try_write_and_take_lose_no_data<lockfree::SpscExchangeBuffer<uint64_t>>();
+}
+
+TEST(SpscBufferStressTest, take_buffer_loses_no_data_with_try_write) {
+  try_write_and_take_lose_no_data<lockfree::SpscTakeBuffer<uint64_t>>();
+}
+
+// the consumer sees consistent values in order with all read operations
+TEST(SpscBufferStressTest, exchange_buffer_values_are_consistent_and_ordered) {
+  lockfree::SpscExchangeBuffer<Sample> buffer;
+  std::atomic<bool> run{true};
+  uint64_t numConsumed = 0;
+  bool consistent = true;
+  bool ordered = true;
+
+  std::thread producer([&] {
+    uint64_t value = 0;
+    while (run) {
+      if (value % 2 == 0) {
+        buffer.write(Sample(++value));
+      } else {
+        auto loan = buffer.loan();
+        loan.emplace(++value);
+        buffer.publish(std::move(loan));
+      }
+      if (value % 16 == 0) {
+        std::this_thread::yield(); // let the consumer run on few cores
+      }
+    }
+  });
+
+  std::thread consumer([&] {
+    uint64_t prev = 0;
+    auto check = [&](const Sample &sample) {
+      consistent = consistent && sample.consistent();
+      ordered = ordered && sample.values[0] >= prev;
+      prev = sample.values[0];
+      ++numConsumed;
+    };
+
+    for (uint64_t i = 0; run; ++i) {
+      if (buffer.empty()) {
+        std::this_thread::yield();
+      }
+      switch (i % 4) {
+      case 0:
+        if (auto result = buffer.read()) {
+          check(*result);
+        }
+        break;
+      case 1:
+        if (auto result = buffer.take()) {
+          check(*result);
+        }
+        break;
+      case 2:
+        if (auto handle = buffer.read_handle()) {
+          check(*handle);
+          std::this_thread::yield(); // keep the slot pinned for a while
+          check(*handle);
+        }
+        break;
+      default:
+        if (auto handle = buffer.take_handle()) {
+          check(*handle);
+          std::this_thread::yield();
+          check(*handle);
+        }
+      }
+    }
+  });
+
+  std::this_thread::sleep_for(runtime);
+  run = false;
+  producer.join();
+  consumer.join();
+
+  std::cout << "consumed " << numConsumed << std::endl;
+  EXPECT_TRUE(consistent);
+  EXPECT_TRUE(ordered);
+}
+
+} // namespace
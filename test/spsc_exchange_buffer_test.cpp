@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/concurrency.hpp"
+
+#include <type_traits>
+
+namespace {
+
+using IntBuffer = lockfree::ExchangeBufferFor<int, lockfree::Producers::Single,
+                                              lockfree::Consumers::Single>;
+
+static_assert(std::is_same_v<IntBuffer, lockfree::SpscExchangeBuffer<int>>);
+static_assert(std::is_same_v<lockfree::ExchangeBufferFor<int>,
+                             lockfree::ExchangeBuffer<int>>);
+static_assert(
+    std::is_same_v<lockfree::ExchangeBufferFor<int, lockfree::Producers::Single,
+                                               lockfree::Consumers::Multiple>,
+                   lockfree::ExchangeBuffer<int>>);
+
+class TestSpscExchangeBuffer : public ::testing::Test {
+public:
+  IntBuffer buffer;
+};
+
+TEST_F(TestSpscExchangeBuffer, take_returns_nothing_if_empty) {
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_FALSE(buffer.take().has_value());
+  EXPECT_FALSE(buffer.read().has_value());
+}
+
+TEST_F(TestSpscExchangeBuffer, write_overwrites_previous_value) {
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(buffer.write(i));
+  }
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 7);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_FALSE(buffer.take().has_value());
+}
+
+TEST_F(TestSpscExchangeBuffer, try_write_fails_if_not_empty) {
+  EXPECT_TRUE(buffer.try_write(37));
+  EXPECT_FALSE(buffer.try_write(73));
+
+  // still not empty if the value was read (moved to the consumer side)
+  EXPECT_TRUE(buffer.read().has_value());
+  EXPECT_FALSE(buffer.empty());
+  EXPECT_FALSE(buffer.try_write(73));
+
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 37);
+  EXPECT_TRUE(buffer.try_write(73));
+}
+
+TEST_F(TestSpscExchangeBuffer, take_and_read_assign_to_existing_object) {
+  int out = 21;
+  EXPECT_FALSE(buffer.take(out));
+  EXPECT_FALSE(buffer.read(out));
+  EXPECT_EQ(out, 21);
+  EXPECT_TRUE(buffer.write(73));
+  EXPECT_TRUE(buffer.read(out));
+  EXPECT_EQ(out, 73);
+  EXPECT_TRUE(buffer.write(37));
+  EXPECT_TRUE(buffer.take(out));
+  EXPECT_EQ(out, 37);
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST_F(TestSpscExchangeBuffer, read_does_not_remove_value) {
+  EXPECT_TRUE(buffer.write(73));
+  for (int i = 0; i < 2; ++i) {
+    auto result = buffer.read();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 73);
+    EXPECT_FALSE(buffer.empty());
+  }
+
+  EXPECT_TRUE(buffer.write(37));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 37);
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST_F(TestSpscExchangeBuffer, published_loan_is_written_to_buffer) {
+  auto loan = buffer.loan();
+  ASSERT_TRUE(loan);
+  EXPECT_FALSE(buffer.loan()); // only one loan at a time
+  loan.emplace(37);
+  *loan += 36;
+  EXPECT_TRUE(buffer.empty());
+
+  EXPECT_TRUE(buffer.publish(std::move(loan)));
+  auto result = buffer.read();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+}
+
+TEST_F(TestSpscExchangeBuffer, dropped_loan_returns_the_slot) {
+  {
+    auto loan = buffer.loan();
+    ASSERT_TRUE(loan);
+    EXPECT_FALSE(buffer.write(73));
+    EXPECT_FALSE(buffer.publish(std::move(loan))); // no value
+  }
+  EXPECT_TRUE(buffer.write(73));
+}
+
+TEST_F(TestSpscExchangeBuffer, pinned_value_is_not_overwritten_by_writes) {
+  EXPECT_TRUE(buffer.write(73));
+  auto handle = buffer.read_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_FALSE(buffer.read_handle()); // only one handle at a time
+
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(buffer.write(i));
+    auto result = buffer.read();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, i);
+  }
+  EXPECT_EQ(*handle, 73);
+
+  handle.reset();
+  EXPECT_TRUE(buffer.write(37));
+  handle = buffer.read_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_EQ(*handle, 37);
+}
+
+TEST_F(TestSpscExchangeBuffer, take_handle_removes_value) {
+  EXPECT_TRUE(buffer.write(73));
+  auto handle = buffer.take_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_TRUE(buffer.empty());
+
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(buffer.write(i));
+    auto result = buffer.take();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, i);
+  }
+  EXPECT_EQ(*handle, 73);
+  EXPECT_FALSE(buffer.take_handle());
+
+  handle.reset();
+  EXPECT_TRUE(buffer.write(37));
+  handle = buffer.take_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_EQ(*handle, 37);
+}
+
+} // namespace
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/concurrency.hpp"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+using StringBuffer =
+    lockfree::TakeBufferFor<std::string, lockfree::Producers::Single,
+                            lockfree::Consumers::Single>;
+
+static_assert(
+    std::is_same_v<StringBuffer, lockfree::SpscTakeBuffer<std::string>>);
+static_assert(
+    std::is_same_v<lockfree::TakeBufferFor<int>, lockfree::TakeBuffer<int>>);
+
+class TestSpscTakeBuffer : public ::testing::Test {
+public:
+  StringBuffer buffer;
+};
+
+TEST_F(TestSpscTakeBuffer, take_returns_nothing_if_empty) {
+  EXPECT_FALSE(buffer.take().has_value());
+  EXPECT_FALSE(buffer.take_handle());
+}
+
+TEST_F(TestSpscTakeBuffer, write_overwrites_previous_value) {
+  EXPECT_TRUE(buffer.write("73"));
+  EXPECT_TRUE(buffer.write("37"));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, "37");
+  EXPECT_FALSE(buffer.take().has_value());
+}
+
+TEST_F(TestSpscTakeBuffer, try_write_fails_if_not_empty) {
+  EXPECT_TRUE(buffer.try_write("37"));
+  EXPECT_FALSE(buffer.try_write("73"));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, "37");
+  EXPECT_TRUE(buffer.try_write("73"));
+}
+
+TEST_F(TestSpscTakeBuffer, take_assigns_to_existing_object) {
+  std::string out = "21";
+  EXPECT_FALSE(buffer.take(out));
+  EXPECT_EQ(out, "21");
+  EXPECT_TRUE(buffer.write("73"));
+  EXPECT_TRUE(buffer.take(out));
+  EXPECT_EQ(out, "73");
+  EXPECT_FALSE(buffer.take(out));
+}
+
+TEST_F(TestSpscTakeBuffer, emplace_constructs_value_in_buffer) {
+  EXPECT_TRUE(buffer.emplace(3, 'x'));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, "xxx");
+}
+
+TEST_F(TestSpscTakeBuffer, take_handle_keeps_value_until_released) {
+  EXPECT_TRUE(buffer.write("73"));
+  auto handle = buffer.take_handle();
+  ASSERT_TRUE(handle);
+
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(buffer.write(std::to_string(i)));
+    auto result = buffer.take();
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, std::to_string(i));
+  }
+  EXPECT_EQ(*handle, "73");
+
+  EXPECT_TRUE(buffer.write("37"));
+  EXPECT_FALSE(buffer.take_handle()); // only one handle at a time
+  handle.reset();
+  handle = buffer.take_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_EQ(*handle, "37");
+}
+
+TEST(TestSpscTakeBufferLifetime, values_are_destroyed) {
+  auto value = std::make_shared<int>(73);
+  {
+    lockfree::SpscTakeBuffer<std::shared_ptr<int>> buffer;
+    EXPECT_TRUE(buffer.write(value));
+    EXPECT_TRUE(buffer.write(value)); // overwrites the first copy
+    EXPECT_EQ(value.use_count(), 2);
+    {
+      auto handle = buffer.take_handle();
+      EXPECT_EQ(value.use_count(), 2);
+    }
+    EXPECT_EQ(value.use_count(), 1);
+    EXPECT_TRUE(buffer.write(value));
+    EXPECT_EQ(value.use_count(), 2);
+  }
+  // the destructor destroys the value which was not taken
+  EXPECT_EQ(value.use_count(), 1);
+}
+
+} // namespace
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "lockfree/dwcas_sync_counter.hpp"
 #include "lockfree/sync_counter.hpp"
 #include <atomic>
 #include <chrono>
@@ -15,8 +16,7 @@ constexpr int NUM_READER_THREADS = 8;
 constexpr int NUM_THREADS = NUM_WRITER_THREADS + NUM_READER_THREADS;
 constexpr std::chrono::seconds runtime(2);
 
-using SyncCounter = lockfree::SyncCounter;
-
+template <class SyncCounter>
 void increment(SyncCounter &counter, std::atomic<bool> &run, int id,
                uint64_t &numIncs) {
   numIncs = 0;
@@ -28,6 +28,7 @@ void increment(SyncCounter &counter, std::atomic<bool> &run, int id,
   }
 }
 
+template <class SyncCounter>
 void read(SyncCounter &counter, std::atomic<bool> &run, int id, uint64_t &max) {
   max = 0;
   while (run) {
@@ -36,13 +37,27 @@ void read(SyncCounter &counter, std::atomic<bool> &run, int id, uint64_t &max) {
       max = value;
     }
   }
+  // the readers are stopped after the writers, i.e. the last sync sees the
+  // final count (even if the reader was not scheduled since the last write)
+  max = counter.sync();
 }
 
 // Using try_write data cannot disappear by being discarded and can only be
 // taken by exactly one thread. We hence can check whether no data is lost.
-TEST(SyncCounterStressTest, counters_are_always_in_sync_when_read) {
+template <class SyncCounter>
+class SyncCounterStressTest : public ::testing::Test {};
+
+#if LOCKFREE_HAS_DWCAS
+using SyncCounters =
+    ::testing::Types<lockfree::SyncCounter, lockfree::DwcasSyncCounter>;
+#else
+using SyncCounters = ::testing::Types<lockfree::SyncCounter>;
+#endif
+TYPED_TEST_SUITE(SyncCounterStressTest, SyncCounters);
+
+TYPED_TEST(SyncCounterStressTest, counters_are_always_in_sync_when_read) {
 
-  SyncCounter counter;
+  TypeParam counter;
   std::vector<uint64_t> incs(NUM_WRITER_THREADS, 0);
   std::vector<uint64_t> maxRead(NUM_READER_THREADS, 1);
   std::vector<std::thread> writers;
@@ -54,13 +69,13 @@ TEST(SyncCounterStressTest, counters_are_always_in_sync_when_read) {
   std::atomic<bool> runWriters{true};
 
   for (int i = 0; i < NUM_READER_THREADS; ++i) {
-    readers.emplace_back(&read, std::ref(counter), std::ref(runReaders), i,
-                         std::ref(maxRead[i]));
+    readers.emplace_back(&read<TypeParam>, std::ref(counter),
+                         std::ref(runReaders), i, std::ref(maxRead[i]));
   }
 
   for (int i = 0; i < NUM_WRITER_THREADS; ++i) {
-    writers.emplace_back(&increment, std::ref(counter), std::ref(runWriters), i,
-                         std::ref(incs[i]));
+    writers.emplace_back(&increment<TypeParam>, std::ref(counter),
+                         std::ref(runWriters), i, std::ref(incs[i]));
   }
 
   std::this_thread::sleep_for(runtime);
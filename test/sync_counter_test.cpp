@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/sync_counter.hpp"
+#include "lockfree/test_hooks.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// requires LOCKFREE_TEST_HOOKS (cf. test/CMakeLists.txt)
+
+namespace {
+
+using lockfree::SyncCounter;
+using lockfree::test_hooks::Point;
+
+// the hook blocks the thread that is marked as paused at a point until the
+// test resumes it (deterministic interleaving) and delays all threads at a
+// point by a configurable duration
+std::atomic<bool> paused{false};
+std::atomic<bool> resumed{false};
+std::atomic<int> helpCount{0};
+std::atomic<int> delayUs{0};
+thread_local bool pauseThisThread = false;
+
+void hook(Point point) {
+  if (point == Point::SyncCounterBeforeHelp) {
+    ++helpCount;
+  }
+  if (point != Point::SyncCounterBetweenIncrements) {
+    return;
+  }
+  if (pauseThisThread) {
+    pauseThisThread = false;
+    paused = true;
+    while (!resumed) {
+      std::this_thread::yield();
+    }
+  }
+  if (auto us = delayUs.load()) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+}
+
+class TestSyncCounter : public ::testing::Test {
+public:
+  void SetUp() override {
+    paused = false;
+    resumed = false;
+    helpCount = 0;
+    delayUs = 0;
+    lockfree::test_hooks::hook = &hook;
+  }
+
+  void TearDown() override { lockfree::test_hooks::hook = nullptr; }
+
+  // start an increment that stops between the increments of both counters
+  std::thread start_paused_increment(SyncCounter &counter) {
+    std::thread thread([&] {
+      pauseThisThread = true;
+      counter.increment();
+    });
+    while (!paused) {
+      std::this_thread::yield();
+    }
+    return thread;
+  }
+};
+
+TEST_F(TestSyncCounter, increment) {
+  SyncCounter counter;
+  EXPECT_EQ(counter.sync(), 0);
+  counter.increment();
+  counter.increment();
+  EXPECT_EQ(counter.sync(), 2);
+  EXPECT_EQ(helpCount, 0);
+}
+
+TEST_F(TestSyncCounter, sync_helps_an_incomplete_increment) {
+  SyncCounter counter;
+  auto thread = start_paused_increment(counter);
+
+  EXPECT_EQ(counter.sync(), 1);
+  EXPECT_EQ(helpCount, 1);
+  auto values = counter.get_if_equal();
+  EXPECT_EQ(values.first, 1);
+  EXPECT_EQ(values.second, 1);
+
+  // the paused increment does not increment again
+  resumed = true;
+  thread.join();
+  EXPECT_EQ(counter.sync(), 1);
+}
+
+TEST_F(TestSyncCounter, increment_helps_an_incomplete_increment) {
+  SyncCounter counter;
+  auto thread = start_paused_increment(counter);
+
+  // does not wait for the paused thread
+  counter.increment();
+  EXPECT_EQ(helpCount, 1);
+  EXPECT_EQ(counter.sync(), 2);
+
+  resumed = true;
+  thread.join();
+  EXPECT_EQ(counter.sync(), 2);
+}
+
+// delayed increments are helped by concurrent increments
+TEST_F(TestSyncCounter, concurrent_delayed_increments) {
+  constexpr int NUM_THREADS = 4;
+  constexpr int NUM_INCREMENTS = 100;
+  delayUs = 100;
+  SyncCounter counter;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < NUM_INCREMENTS; ++j) {
+        counter.increment();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.sync(), NUM_THREADS * NUM_INCREMENTS);
+  EXPECT_GT(helpCount, 0);
+}
+
+} // namespace
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "lockfree/take_buffer.hpp"
+
+#include <vector>
+
+namespace {
+
+using IntBuffer = lockfree::TakeBuffer<int>;
+
+class TestTakeBuffer : public ::testing::Test {
+public:
+  IntBuffer buffer;
+};
+
+TEST_F(TestTakeBuffer, take_returns_nothing_if_empty) {
+  auto result = buffer.take();
+  EXPECT_FALSE(result.has_value());
+}
+
+TEST_F(TestTakeBuffer, write_overwrites_previous_value) {
+  EXPECT_TRUE(buffer.write(73));
+  EXPECT_TRUE(buffer.write(37));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 37);
+  EXPECT_FALSE(buffer.take().has_value());
+}
+
+TEST_F(TestTakeBuffer, try_write_fails_if_not_empty) {
+  EXPECT_TRUE(buffer.try_write(37));
+  EXPECT_FALSE(buffer.try_write(73));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 37);
+}
+
+TEST_F(TestTakeBuffer, take_assigns_to_existing_object) {
+  int out = 21;
+  EXPECT_FALSE(buffer.take(out));
+  EXPECT_EQ(out, 21);
+  EXPECT_TRUE(buffer.write(73));
+  EXPECT_TRUE(buffer.take(out));
+  EXPECT_EQ(out, 73);
+  EXPECT_FALSE(buffer.take(out));
+  EXPECT_EQ(out, 73);
+}
+
+TEST_F(TestTakeBuffer, emplace_constructs_value_in_buffer) {
+  EXPECT_TRUE(buffer.emplace(73));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+}
+
+TEST_F(TestTakeBuffer, published_loan_is_written_to_buffer) {
+  auto loan = buffer.loan();
+  ASSERT_TRUE(loan);
+  loan.emplace(73);
+  EXPECT_TRUE(buffer.publish(std::move(loan)));
+  auto result = buffer.take();
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(*result, 73);
+}
+
+TEST_F(TestTakeBuffer, write_fails_if_all_slots_are_loaned) {
+  std::vector<IntBuffer::loan_t> loans;
+  while (auto loan = buffer.loan()) {
+    loans.push_back(std::move(loan));
+  }
+  EXPECT_FALSE(buffer.write(73));
+
+  loans.pop_back();
+  EXPECT_TRUE(buffer.write(73));
+}
+
+TEST_F(TestTakeBuffer, take_handle_removes_value_and_frees_slot_on_reset) {
+  EXPECT_FALSE(buffer.take_handle());
+  EXPECT_TRUE(buffer.write(73));
+  auto handle = buffer.take_handle();
+  ASSERT_TRUE(handle);
+  EXPECT_EQ(*handle, 73);
+  EXPECT_FALSE(buffer.take().has_value());
+
+  std::vector<IntBuffer::loan_t> loans;
+  while (auto loan = buffer.loan()) {
+    loans.push_back(std::move(loan));
+  }
+  EXPECT_EQ(loans.size(), 7);
+  handle.reset();
+  EXPECT_TRUE(buffer.loan());
+}
+
+} // namespace